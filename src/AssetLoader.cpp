@@ -0,0 +1,156 @@
+//--------------------------------------------------------------
+//
+//  AssetLoader
+//
+//--------------------------------------------------------------
+
+#include "AssetLoader.h"
+
+AssetLoader::~AssetLoader() {
+	{
+		lock_guard<mutex> guard(lock);
+		bQuit = true;
+	}
+	wake.notify_all();
+	for (int i = 0; i < int(workers.size()); i++) workers[i].join();
+}
+
+int AssetLoader::add(const string & name, float weight, function<void()> work, function<void()> finish, int after) {
+	lock_guard<mutex> guard(lock);
+	AssetTask task;
+	task.name = name;
+	task.weight = weight;
+	task.work = work;
+	task.finish = finish;
+	task.after = after;
+	tasks.push_back(task);
+	bDone = false;
+	return tasks.size() - 1;
+}
+
+void AssetLoader::start(int numThreads) {
+	if (numThreads < 1) numThreads = max(1, int(thread::hardware_concurrency()) - 1);
+	startTime = ofGetElapsedTimeMicros();
+	{
+		lock_guard<mutex> guard(lock);
+		schedule();
+	}
+	for (int i = 0; i < numThreads; i++) {
+		workers.push_back(thread(&AssetLoader::workerThread, this));
+	}
+}
+
+// schedule:  release the waiting tasks whose dependency is done - to the
+// workers if they have work, else straight to the main thread.  Called
+// with the lock held.
+//
+void AssetLoader::schedule() {
+	bool bQueued = false;
+	for (int i = 0; i < int(tasks.size()); i++) {
+		AssetTask & task = tasks[i];
+		if (task.state != AssetTask::Waiting) continue;
+		if (task.after >= 0 && tasks[task.after].state != AssetTask::Done) continue;
+		if (task.work) {
+			task.state = AssetTask::Queued;
+			queue.push_back(i);
+			bQueued = true;
+		}
+		else {
+			task.state = AssetTask::Finishing;
+		}
+	}
+	if (bQueued) wake.notify_all();
+}
+
+void AssetLoader::workerThread() {
+	while (true) {
+		int id;
+		function<void()> work;
+		{
+			unique_lock<mutex> guard(lock);
+			wake.wait(guard, [this] { return bQuit || !queue.empty(); });
+			if (bQuit) return;
+			id = queue.front();
+			queue.pop_front();
+			tasks[id].state = AssetTask::Working;
+			work = tasks[id].work;
+		}
+
+		uint64_t t1 = ofGetElapsedTimeMicros();
+		work();
+		uint64_t t2 = ofGetElapsedTimeMicros();
+
+		lock_guard<mutex> guard(lock);
+		tasks[id].time += (t2 - t1) / 1000.0;
+		tasks[id].state = AssetTask::Finishing;
+	}
+}
+
+// update:  run the finish steps that are ready, at least one and then as
+// many as fit in budgetMs
+//
+void AssetLoader::update(float budgetMs) {
+	uint64_t t0 = ofGetElapsedTimeMicros();
+	while (true) {
+		int id = -1;
+		function<void()> finish;
+		{
+			lock_guard<mutex> guard(lock);
+			for (int i = 0; i < int(tasks.size()) && id < 0; i++) {
+				if (tasks[i].state == AssetTask::Finishing) id = i;
+			}
+			if (id < 0) break;
+			finish = tasks[id].finish;
+		}
+
+		uint64_t t1 = ofGetElapsedTimeMicros();
+		if (finish) finish();
+		uint64_t t2 = ofGetElapsedTimeMicros();
+
+		lock_guard<mutex> guard(lock);
+		tasks[id].time += (t2 - t1) / 1000.0;
+		tasks[id].state = AssetTask::Done;
+		schedule();
+		if ((t2 - t0) / 1000.0 > budgetMs) break;
+	}
+
+	lock_guard<mutex> guard(lock);
+	if (bDone) return;
+	for (int i = 0; i < int(tasks.size()); i++) {
+		if (tasks[i].state != AssetTask::Done) return;
+	}
+	bDone = true;
+	totalTime = (ofGetElapsedTimeMicros() - startTime) / 1000.0;
+	float sum = 0;
+	for (int i = 0; i < int(tasks.size()); i++) {
+		ofLogVerbose("AssetLoader") << "loaded " << tasks[i].name << " in " << tasks[i].time << " ms";
+		sum += tasks[i].time;
+	}
+	ofLogNotice("AssetLoader") << "loading took " << totalTime << " ms (" << sum << " ms of work)";
+}
+
+float AssetLoader::progress() {
+	lock_guard<mutex> guard(lock);
+	float total = 0, done = 0;
+	for (int i = 0; i < int(tasks.size()); i++) {
+		total += tasks[i].weight;
+		if (tasks[i].state == AssetTask::Done) done += tasks[i].weight;
+	}
+	return total > 0 ? done / total : 1;
+}
+
+bool AssetLoader::done() {
+	lock_guard<mutex> guard(lock);
+	return bDone;
+}
+
+string AssetLoader::status() {
+	lock_guard<mutex> guard(lock);
+	string s;
+	for (int i = 0; i < int(tasks.size()); i++) {
+		if (tasks[i].state == AssetTask::Working || tasks[i].state == AssetTask::Finishing) {
+			s += (s.empty() ? "" : ", ") + tasks[i].name;
+		}
+	}
+	return s;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  AssetLoader
+//
+//  Description:
+//  Startup loading in stages.  Each task has an optional
+//  work step, run on a worker thread (file reads, decoding,
+//  building the octree), and an optional finish step, run on
+//  the main thread from update() (anything that touches GL or
+//  the sound system).  Finish steps run one after the other
+//  within a time budget per frame, so the app can keep drawing
+//  its loading screen in between.
+//
+//  A task may wait for another one (after), e.g. the octree
+//  build waits for the terrain model.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class AssetTask {
+public:
+	enum State { Waiting, Queued, Working, Finishing, Done };
+
+	string name;
+	float weight = 1;               // share of the progress bar
+	function<void()> work;
+	function<void()> finish;
+	int after = -1;
+	State state = Waiting;
+	float time = 0;                 // ms, work and finish
+};
+
+class AssetLoader {
+public:
+	~AssetLoader();
+
+	// returns the task id to use as after for later tasks
+	//
+	int add(const string & name, float weight, function<void()> work, function<void()> finish, int after = -1);
+
+	// start the workers (numThreads 0 = one less than the cores)
+	//
+	void start(int numThreads = 0);
+
+	// main thread, once per frame
+	//
+	void update(float budgetMs = 8);
+
+	float progress();               // 0 - 1
+	bool done();
+	string status();                // names of the tasks in progress
+
+	float totalTime = 0;            // ms from start() to the last task done
+
+private:
+	void workerThread();
+	void schedule();
+
+	vector<AssetTask> tasks;
+	deque<int> queue;
+	vector<thread> workers;
+	mutex lock;
+	condition_variable wake;
+	bool bQuit = false;
+	bool bDone = false;
+	uint64_t startTime = 0;
+};
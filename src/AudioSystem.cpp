@@ -0,0 +1,128 @@
+//--------------------------------------------------------------
+//
+//  AudioSystem
+//
+//--------------------------------------------------------------
+
+#include "AudioSystem.h"
+
+int AudioSystem::addStream(const string & path, float volume, bool loop) {
+	AudioSound s;
+	s.path = path;
+	s.volume = volume;
+	s.bStream = true;
+	s.bLoop = loop;
+	sounds.push_back(s);
+	return sounds.size() - 1;
+}
+
+int AudioSystem::addEffect(const string & path, float volume, int voices) {
+	AudioSound s;
+	s.path = path;
+	s.volume = volume;
+	s.numVoices = max(1, voices);
+	sounds.push_back(s);
+	return sounds.size() - 1;
+}
+
+void AudioSystem::start() {
+	if (worker.joinable()) return;
+	bQuit = false;
+	triggers.assign(sounds.size(), 0);
+	holds.assign(sounds.size(), 0);
+	worker = thread(&AudioSystem::audioThread, this);
+}
+
+void AudioSystem::stop() {
+	if (!worker.joinable()) return;
+	bQuit = true;
+	worker.join();
+}
+
+bool AudioSystem::send(int sound, AudioCommand::Type type) {
+	if (sound < 0 || sound >= int(sounds.size())) return false;
+	AudioCommand c;
+	c.sound = sound;
+	c.type = type;
+	if (commands.push(c)) return true;
+	dropped++;
+	return false;
+}
+
+void AudioSystem::load(AudioSound & s) {
+	int n = s.bStream ? 1 : s.numVoices;
+	s.voices.resize(n);
+	for (int i = 0; i < n; i++) {
+		ofSoundPlayer & voice = s.voices[i];
+		if (!voice.load(s.path, s.bStream)) {
+			ofLogError("AudioSystem") << "can't load " << s.path;
+			s.voices.clear();
+			return;
+		}
+		voice.setLoop(s.bLoop);
+		voice.setVolume(s.volume);
+		voice.setMultiPlay(false);
+	}
+}
+
+// audioThread:  load everything, then every tick apply the commands that
+// came in and let the sound backend update (stream decoding, finished
+// channels)
+//
+void AudioSystem::audioThread() {
+	for (int i = 0; i < int(sounds.size()); i++) load(sounds[i]);
+	bLoaded = true;
+
+	while (!bQuit) {
+		apply();
+		ofSoundUpdate();
+		this_thread::sleep_for(chrono::milliseconds(tickMs));
+	}
+	for (int i = 0; i < int(sounds.size()); i++) {
+		for (int v = 0; v < int(sounds[i].voices.size()); v++) sounds[i].voices[v].stop();
+	}
+}
+
+// apply:  collapse the queue into the last hold state and the trigger
+// count of each sound, then act on that
+//
+void AudioSystem::apply() {
+	AudioCommand c;
+	while (commands.pop(c)) {
+		switch (c.type) {
+		case AudioCommand::Trigger: triggers[c.sound]++; break;
+		case AudioCommand::Hold: holds[c.sound] = 1; break;
+		case AudioCommand::Release: holds[c.sound] = -1; break;
+		}
+	}
+
+	for (int i = 0; i < int(sounds.size()); i++) {
+		AudioSound & s = sounds[i];
+		if (s.voices.empty()) {
+			triggers[i] = holds[i] = 0;
+			continue;
+		}
+		if (holds[i] > 0) s.bHeld = true;
+		else if (holds[i] < 0) {
+			s.bHeld = false;
+			for (int v = 0; v < int(s.voices.size()); v++) {
+				if (s.voices[v].isPlaying()) s.voices[v].stop();
+			}
+		}
+		holds[i] = 0;
+
+		// a held sound keeps its first voice going (again from the start
+		// once a sound that doesn't loop runs out)
+		//
+		if (s.bHeld && !s.voices[0].isPlaying()) s.voices[0].play();
+
+		// more triggers in one tick than voices only replay the same ones
+		//
+		int n = min(triggers[i], int(s.voices.size()));
+		for (int k = 0; k < n; k++) {
+			s.voices[s.nextVoice].play();
+			s.nextVoice = (s.nextVoice + 1) % s.voices.size();
+		}
+		triggers[i] = 0;
+	}
+}
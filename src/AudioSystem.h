@@ -0,0 +1,92 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  AudioSystem
+//
+//  Description:
+//  All sound on a thread of its own.  The sounds are declared
+//  up front; start() loads them on the audio thread, which
+//  from then on owns every player:  other threads only queue
+//  commands (a lock-free ring, see SpscQueue), so no sound call
+//  can stall a frame.
+//
+//  Streams (the ambient track) are opened for streaming, so
+//  they are decoded from disk a small buffer at a time by the
+//  sound backend instead of sitting in memory as PCM.  Effects
+//  are loaded in full into a fixed pool of voices each; a
+//  trigger takes the next voice round robin, cutting the oldest
+//  one short if they are all busy.
+//
+//  The audio thread drains the queue every tick and applies
+//  only the last state asked for each sound, so a hold sound
+//  (the thruster) switched off and on between two ticks keeps
+//  playing instead of restarting.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <thread>
+
+class AudioCommand {
+public:
+	enum Type { Trigger, Hold, Release };
+	int sound;
+	Type type;
+};
+
+class AudioSound {
+public:
+	string path;
+	float volume = 1;
+	bool bStream = false;
+	bool bLoop = false;
+	int numVoices = 1;
+	int nextVoice = 0;                  // audio thread
+	bool bHeld = false;                 // audio thread
+	vector<ofSoundPlayer> voices;       // audio thread
+};
+
+class AudioSystem {
+public:
+	static const int queueSize = 64;
+	static const int tickMs = 10;
+
+	~AudioSystem() { stop(); }
+
+	// before start():  declare a streamed track or a pooled effect,
+	// returns its id
+	//
+	int addStream(const string & path, float volume, bool loop = true);
+	int addEffect(const string & path, float volume, int voices = 1);
+
+	void start();
+	void stop();
+	bool loaded() const { return bLoaded; }
+
+	// any one thread:  queue a command, false if the queue is full.
+	// trigger() plays the effect on a voice from the start; hold() keeps
+	// one voice of the sound playing until release().
+	//
+	bool trigger(int sound) { return send(sound, AudioCommand::Trigger); }
+	bool hold(int sound) { return send(sound, AudioCommand::Hold); }
+	bool release(int sound) { return send(sound, AudioCommand::Release); }
+
+	int dropped = 0;                    // commands lost to a full queue
+
+private:
+	bool send(int sound, AudioCommand::Type type);
+	void audioThread();
+	void load(AudioSound & s);
+	void apply();
+
+	vector<AudioSound> sounds;
+	vector<int> triggers;               // per sound, this tick (audio thread)
+	vector<int> holds;                  // per sound, -1 release, 1 hold, 0 no change
+	SpscQueue<AudioCommand, queueSize> commands;
+	thread worker;
+	atomic<bool> bQuit { false };
+	atomic<bool> bLoaded { false };
+};
@@ -0,0 +1,429 @@
+//--------------------------------------------------------------
+//
+//  BVH
+//
+//  Binned SAH build, after Wald, "On fast Construction of
+//  SAH-based Bounding Volume Hierarchies", 2007.
+//
+//--------------------------------------------------------------
+
+#include "BVH.h"
+
+// depth cap for the build; the traversal stacks hold at most one
+// pending sibling per level
+//
+static const int maxDepth = 64;
+static const int stackSize = maxDepth * 2;
+static const int maxBins = 32;
+
+static Box toBox(const glm::vec3 & min, const glm::vec3 & max) {
+	return Box(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z));
+}
+
+static float area(const glm::vec3 & min, const glm::vec3 & max) {
+	glm::vec3 d = max - min;
+	return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+// build:  copy the vertex positions and faces of mesh and build the
+// hierarchy.  Meshes without indices are read as consecutive triangles.
+//
+void BVH::build(const ofMesh & mesh) {
+	uint64_t t1 = ofGetElapsedTimeMicros();
+
+	vertices = mesh.getVertices();
+	indices.clear();
+	if (mesh.getNumIndices() > 0) {
+		for (int i = 0; i + 2 < int(mesh.getNumIndices()); i += 3) {
+			indices.push_back(mesh.getIndex(i));
+			indices.push_back(mesh.getIndex(i + 1));
+			indices.push_back(mesh.getIndex(i + 2));
+		}
+	}
+	else {
+		for (int i = 0; i + 2 < int(vertices.size()); i += 3) {
+			indices.push_back(i);
+			indices.push_back(i + 1);
+			indices.push_back(i + 2);
+		}
+	}
+
+	int numTris = indices.size() / 3;
+	vector<glm::vec3> centroids(numTris);
+	vector<glm::vec3> triMin(numTris);
+	vector<glm::vec3> triMax(numTris);
+	triangles.resize(numTris);
+	for (int i = 0; i < numTris; i++) {
+		const glm::vec3 & a = vertices[indices[i * 3]];
+		const glm::vec3 & b = vertices[indices[i * 3 + 1]];
+		const glm::vec3 & c = vertices[indices[i * 3 + 2]];
+		triMin[i] = glm::min(a, glm::min(b, c));
+		triMax[i] = glm::max(a, glm::max(b, c));
+		centroids[i] = (a + b + c) / 3.0f;
+		triangles[i] = i;
+	}
+
+	nodes.clear();
+	nodes.reserve(numTris > 0 ? numTris * 2 : 1);
+	BVHNode root;
+	root.first = 0;
+	root.count = numTris;
+	nodes.push_back(root);
+	depth = 0;
+	subdivide(0, 1, centroids, triMin, triMax);
+	nodes.shrink_to_fit();
+
+	uint64_t t2 = ofGetElapsedTimeMicros();
+	buildTime = (t2 - t1) / 1000.0;
+}
+
+// subdivide:  fit the node's box to its triangles, then bin the triangle
+// centroids along the longest axis and split at the cheapest bin
+// boundary.  The node stays a leaf if no split beats testing all of its
+// triangles.
+//
+void BVH::subdivide(int n, int level, const vector<glm::vec3> & centroids,
+	const vector<glm::vec3> & triMin, const vector<glm::vec3> & triMax)
+{
+	if (level > depth) depth = level;
+	int first = nodes[n].first;
+	int count = nodes[n].count;
+
+	glm::vec3 bmin = glm::vec3(FLT_MAX), bmax = glm::vec3(-FLT_MAX);
+	glm::vec3 cmin = glm::vec3(FLT_MAX), cmax = glm::vec3(-FLT_MAX);
+	for (int i = first; i < first + count; i++) {
+		int t = triangles[i];
+		bmin = glm::min(bmin, triMin[t]);
+		bmax = glm::max(bmax, triMax[t]);
+		cmin = glm::min(cmin, centroids[t]);
+		cmax = glm::max(cmax, centroids[t]);
+	}
+	if (count < 1) bmin = bmax = glm::vec3(0);
+	nodes[n].box = toBox(bmin, bmax);
+	if (count <= 2 || level >= maxDepth) return;
+
+	glm::vec3 extent = cmax - cmin;
+	int axis = 0;
+	if (extent.y > extent[axis]) axis = 1;
+	if (extent.z > extent[axis]) axis = 2;
+	if (extent[axis] <= 0) return;
+
+	// bin the centroids
+	//
+	int numBins = min(max(this->numBins, 2), maxBins);
+	int binCount[maxBins];
+	glm::vec3 binMin[maxBins];
+	glm::vec3 binMax[maxBins];
+	for (int b = 0; b < numBins; b++) {
+		binCount[b] = 0;
+		binMin[b] = glm::vec3(FLT_MAX);
+		binMax[b] = glm::vec3(-FLT_MAX);
+	}
+	float scale = numBins / extent[axis];
+	for (int i = first; i < first + count; i++) {
+		int t = triangles[i];
+		int b = min(numBins - 1, int((centroids[t][axis] - cmin[axis]) * scale));
+		binCount[b]++;
+		binMin[b] = glm::min(binMin[b], triMin[t]);
+		binMax[b] = glm::max(binMax[b], triMax[t]);
+	}
+
+	// sweep from the right to get the cost of every right side, then
+	// from the left to evaluate each split plane
+	//
+	float rightArea[maxBins];
+	int rightCount[maxBins];
+	glm::vec3 rmin = glm::vec3(FLT_MAX), rmax = glm::vec3(-FLT_MAX);
+	int rc = 0;
+	for (int b = numBins - 1; b > 0; b--) {
+		rc += binCount[b];
+		if (binCount[b] > 0) {
+			rmin = glm::min(rmin, binMin[b]);
+			rmax = glm::max(rmax, binMax[b]);
+		}
+		rightCount[b] = rc;
+		rightArea[b] = rc > 0 ? area(rmin, rmax) : 0;
+	}
+
+	float parentArea = area(bmin, bmax);
+	float bestCost = FLT_MAX;
+	int bestSplit = -1;
+	glm::vec3 lmin = glm::vec3(FLT_MAX), lmax = glm::vec3(-FLT_MAX);
+	int lc = 0;
+	for (int b = 0; b < numBins - 1; b++) {
+		lc += binCount[b];
+		if (binCount[b] > 0) {
+			lmin = glm::min(lmin, binMin[b]);
+			lmax = glm::max(lmax, binMax[b]);
+		}
+		if (lc == 0 || rightCount[b + 1] == 0) continue;
+		float cost = traversalCost + intersectCost *
+			(area(lmin, lmax) * lc + rightArea[b + 1] * rightCount[b + 1]) / parentArea;
+		if (cost < bestCost) {
+			bestCost = cost;
+			bestSplit = b;
+		}
+	}
+
+	float leafCost = intersectCost * count;
+	if (bestSplit < 0 || (bestCost >= leafCost && count <= maxLeafTriangles)) return;
+
+	// partition the triangle range around the split plane
+	//
+	int i = first;
+	int j = first + count - 1;
+	while (i <= j) {
+		int t = triangles[i];
+		int b = min(numBins - 1, int((centroids[t][axis] - cmin[axis]) * scale));
+		if (b <= bestSplit) i++;
+		else swap(triangles[i], triangles[j--]);
+	}
+	int leftCount = i - first;
+	if (leftCount == 0 || leftCount == count) return;
+
+	int left = nodes.size();
+	BVHNode child;
+	child.first = first;
+	child.count = leftCount;
+	nodes.push_back(child);
+	child.first = i;
+	child.count = count - leftCount;
+	nodes.push_back(child);
+
+	nodes[n].first = left;
+	nodes[n].count = 0;
+	subdivide(left, level + 1, centroids, triMin, triMax);
+	subdivide(left + 1, level + 1, centroids, triMin, triMax);
+}
+
+// intersectTriangle:  Moller-Trumbore ray/triangle test, t is the
+// distance along d to the hit
+//
+bool BVH::intersectTriangle(const glm::vec3 & o, const glm::vec3 & d, int tri, float & t) const {
+	const glm::vec3 & a = vertices[indices[tri * 3]];
+	const glm::vec3 & b = vertices[indices[tri * 3 + 1]];
+	const glm::vec3 & c = vertices[indices[tri * 3 + 2]];
+	return rayTriangle(o, d, a, b, c, t);
+}
+
+// rayQuery:  closest triangle hit, children visited nearest first
+//
+bool BVH::rayQuery(const Ray & ray, glm::vec3 & pointRtn, QueryStats * stats) const {
+	QUERY_COUNT(stats, queries, 1);
+	if (nodes.size() < 1) return false;
+	glm::vec3 o = glm::vec3(ray.origin.x(), ray.origin.y(), ray.origin.z());
+	glm::vec3 d = glm::vec3(ray.direction.x(), ray.direction.y(), ray.direction.z());
+
+	float tBest = FLT_MAX;
+	float t;
+	int stack[stackSize];
+	int levels[stackSize];
+	int top = 0;
+	stack[top] = 0;
+	levels[top++] = 0;
+	QUERY_COUNT(stats, boxTests, 1);
+	while (top > 0) {
+		const BVHNode & node = nodes[stack[--top]];
+		int level = levels[top];
+		if (!node.box.intersect(ray, 0, tBest, t)) continue;
+		QUERY_COUNT(stats, nodesVisited, 1);
+		QUERY_DEPTH(stats, level);
+		if (node.count > 0) {
+			QUERY_COUNT(stats, leavesReached, 1);
+			for (int i = node.first; i < node.first + node.count; i++) {
+				if (intersectTriangle(o, d, triangles[i], t) && t < tBest) tBest = t;
+			}
+			continue;
+		}
+
+		// push the further child first so the nearer one is popped next
+		//
+		float tl = FLT_MAX, tr = FLT_MAX;
+		QUERY_COUNT(stats, boxTests, 2);
+		bool hl = nodes[node.first].box.intersect(ray, 0, tBest, tl);
+		bool hr = nodes[node.first + 1].box.intersect(ray, 0, tBest, tr);
+		if (hl && hr) {
+			if (tl <= tr) {
+				levels[top] = level + 1;
+				stack[top++] = node.first + 1;
+				levels[top] = level + 1;
+				stack[top++] = node.first;
+			}
+			else {
+				levels[top] = level + 1;
+				stack[top++] = node.first;
+				levels[top] = level + 1;
+				stack[top++] = node.first + 1;
+			}
+		}
+		else if (hl) {
+			levels[top] = level + 1;
+			stack[top++] = node.first;
+		}
+		else if (hr) {
+			levels[top] = level + 1;
+			stack[top++] = node.first + 1;
+		}
+	}
+	if (tBest == FLT_MAX) return false;
+	QUERY_COUNT(stats, results, 1);
+	pointRtn = o + d * tBest;
+	return true;
+}
+
+// boxQuery:  append the leaf boxes overlapping box, true if there were any
+//
+bool BVH::boxQuery(const Box & box, vector<Box> & boxListRtn, QueryStats * stats) const {
+	QUERY_COUNT(stats, queries, 1);
+	if (nodes.size() < 1) return false;
+	int n = boxListRtn.size();
+	int stack[stackSize];
+	int levels[stackSize];
+	int top = 0;
+	stack[top] = 0;
+	levels[top++] = 0;
+	while (top > 0) {
+		const BVHNode & node = nodes[stack[--top]];
+		int level = levels[top];
+		QUERY_COUNT(stats, boxTests, 1);
+		if (!node.box.overlap(box)) continue;
+		QUERY_COUNT(stats, nodesVisited, 1);
+		QUERY_DEPTH(stats, level);
+		if (node.count > 0) {
+			QUERY_COUNT(stats, leavesReached, 1);
+			boxListRtn.push_back(node.box);
+		}
+		else {
+			levels[top] = level + 1;
+			stack[top++] = node.first;
+			levels[top] = level + 1;
+			stack[top++] = node.first + 1;
+		}
+	}
+	QUERY_COUNT(stats, results, boxListRtn.size() - n);
+	return int(boxListRtn.size()) > n;
+}
+
+// same for an oriented box
+//
+bool BVH::boxQuery(const OBB & box, vector<Box> & boxListRtn, QueryStats * stats) const {
+	QUERY_COUNT(stats, queries, 1);
+	if (nodes.size() < 1) return false;
+	int n = boxListRtn.size();
+	int stack[stackSize];
+	int levels[stackSize];
+	int top = 0;
+	stack[top] = 0;
+	levels[top++] = 0;
+	while (top > 0) {
+		const BVHNode & node = nodes[stack[--top]];
+		int level = levels[top];
+		QUERY_COUNT(stats, boxTests, 1);
+		if (!box.overlap(node.box)) continue;
+		QUERY_COUNT(stats, nodesVisited, 1);
+		QUERY_DEPTH(stats, level);
+		if (node.count > 0) {
+			QUERY_COUNT(stats, leavesReached, 1);
+			boxListRtn.push_back(node.box);
+		}
+		else {
+			levels[top] = level + 1;
+			stack[top++] = node.first;
+			levels[top] = level + 1;
+			stack[top++] = node.first + 1;
+		}
+	}
+	QUERY_COUNT(stats, results, boxListRtn.size() - n);
+	return int(boxListRtn.size()) > n;
+}
+
+// triangleQuery:  triangles of the leaves the box overlaps, each leaf
+// holds its own triangles so there are no duplicates
+//
+int BVH::triangleQuery(const OBB & box, vector<int> & trianglesRtn, QueryStats * stats) const {
+	QUERY_COUNT(stats, queries, 1);
+	if (nodes.size() < 1) return 0;
+	int n = trianglesRtn.size();
+	int stack[stackSize];
+	int levels[stackSize];
+	int top = 0;
+	stack[top] = 0;
+	levels[top++] = 0;
+	glm::vec3 a, b, c;
+	while (top > 0) {
+		const BVHNode & node = nodes[stack[--top]];
+		int level = levels[top];
+		QUERY_COUNT(stats, boxTests, 1);
+		if (!box.overlap(node.box)) continue;
+		QUERY_COUNT(stats, nodesVisited, 1);
+		QUERY_DEPTH(stats, level);
+		if (node.count > 0) {
+			QUERY_COUNT(stats, leavesReached, 1);
+			for (int i = node.first; i < node.first + node.count; i++) {
+				triangle(triangles[i], a, b, c);
+				if (triangleOverlaps(box, a, b, c)) trianglesRtn.push_back(triangles[i]);
+			}
+		}
+		else {
+			levels[top] = level + 1;
+			stack[top++] = node.first;
+			levels[top] = level + 1;
+			stack[top++] = node.first + 1;
+		}
+	}
+	QUERY_COUNT(stats, results, trianglesRtn.size() - n);
+	return trianglesRtn.size() - n;
+}
+
+// nearestPoint:  nearest triangle vertex, pruning nodes whose box is
+// further away than the best vertex found so far
+//
+bool BVH::nearestPoint(const glm::vec3 & p, int & pointRtn, QueryStats * stats) const {
+	pointRtn = -1;
+	QUERY_COUNT(stats, queries, 1);
+	if (nodes.size() < 1) return false;
+	Vector3 q = Vector3(p.x, p.y, p.z);
+	float best = FLT_MAX;
+	int stack[stackSize];
+	int levels[stackSize];
+	int top = 0;
+	stack[top] = 0;
+	levels[top++] = 0;
+	while (top > 0) {
+		const BVHNode & node = nodes[stack[--top]];
+		int level = levels[top];
+		QUERY_COUNT(stats, boxTests, 1);
+		if (node.box.distance2(q) >= best) continue;
+		QUERY_COUNT(stats, nodesVisited, 1);
+		QUERY_DEPTH(stats, level);
+		if (node.count > 0) {
+			QUERY_COUNT(stats, leavesReached, 1);
+			for (int i = node.first; i < node.first + node.count; i++) {
+				for (int k = 0; k < 3; k++) {
+					int v = indices[triangles[i] * 3 + k];
+					glm::vec3 d = vertices[v] - p;
+					float d2 = glm::dot(d, d);
+					if (d2 < best) {
+						best = d2;
+						pointRtn = v;
+					}
+				}
+			}
+			continue;
+		}
+		QUERY_COUNT(stats, boxTests, 2);
+		float dl = nodes[node.first].box.distance2(q);
+		float dr = nodes[node.first + 1].box.distance2(q);
+		levels[top] = level + 1;
+		stack[top++] = dl <= dr ? node.first + 1 : node.first;
+		levels[top] = level + 1;
+		stack[top++] = dl <= dr ? node.first : node.first + 1;
+	}
+	QUERY_COUNT(stats, results, pointRtn >= 0 ? 1 : 0);
+	return pointRtn >= 0;
+}
+
+size_t BVH::memoryUsage() const {
+	return sizeof(BVH) + vertices.capacity() * sizeof(glm::vec3) + indices.capacity() * sizeof(int) +
+		triangles.capacity() * sizeof(int) + nodes.capacity() * sizeof(BVHNode);
+}
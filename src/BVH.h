@@ -0,0 +1,66 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  BVH
+//
+//  Description:
+//  Bounding volume hierarchy over the triangles of a mesh,
+//  built top-down with a binned surface area heuristic.
+//  Alternative to the Octree behind the SpatialIndex interface.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+#include "SpatialIndex.h"
+
+// Nodes live in one flat array.  A leaf references the range
+// [first, first + count) of BVH::triangles; an interior node has
+// count == 0 and its children at first and first + 1.
+//
+class BVHNode {
+public:
+	Box box;
+	int first = 0;
+	int count = 0;
+};
+
+class BVH : public SpatialIndex {
+public:
+	void build(const ofMesh & mesh);
+	bool rayQuery(const Ray & ray, glm::vec3 & pointRtn, QueryStats * stats = NULL) const;
+	bool boxQuery(const Box & box, vector<Box> & boxListRtn, QueryStats * stats = NULL) const;
+	bool boxQuery(const OBB & box, vector<Box> & boxListRtn, QueryStats * stats = NULL) const;
+	bool nearestPoint(const glm::vec3 & p, int & pointRtn, QueryStats * stats = NULL) const;
+	int triangleQuery(const OBB & box, vector<int> & trianglesRtn, QueryStats * stats = NULL) const;
+	void triangle(int t, glm::vec3 & a, glm::vec3 & b, glm::vec3 & c) const {
+		a = vertices[indices[t * 3]];
+		b = vertices[indices[t * 3 + 1]];
+		c = vertices[indices[t * 3 + 2]];
+	}
+	size_t memoryUsage() const;
+	string name() const { return "bvh"; }
+
+	bool intersectTriangle(const glm::vec3 & o, const glm::vec3 & d, int tri, float & t) const;
+
+	vector<glm::vec3> vertices;
+	vector<int> indices;        // 3 vertex indices per triangle
+	vector<int> triangles;      // triangle order referenced by the leaves
+	vector<BVHNode> nodes;
+
+	// build settings
+	//
+	int maxLeafTriangles = 4;
+	int numBins = 12;           // at most 32
+	float traversalCost = 1.0;
+	float intersectCost = 1.0;
+
+	// build stats
+	//
+	float buildTime = 0;        // ms
+	int depth = 0;
+
+private:
+	void subdivide(int node, int level, const vector<glm::vec3> & centroids,
+		const vector<glm::vec3> & triMin, const vector<glm::vec3> & triMax);
+};
@@ -0,0 +1,1160 @@
+//--------------------------------------------------------------
+//
+//  Benchmark
+//
+//  Output is one CSV row per measurement:
+//
+//    benchmark,input,param,iterations,total_ms,ns_per_op,value
+//
+//  "value" is a benchmark specific extra (memory in bytes,
+//  hits found, ...) so regressions in results as well as in
+//  time show up in a diff.
+//
+//--------------------------------------------------------------
+
+#include "Benchmark.h"
+#include "Octree.h"
+#include "BVH.h"
+#include "ParticleSystem.h"
+#include "ParticleEmitter.h"
+#include "ParticleBudget.h"
+#include "Lander.h"
+#include "Narrowphase.h"
+#include "Heightfield.h"
+#include "DepthSort.h"
+#include <iomanip>
+#include <thread>
+#include <atomic>
+
+static string benchFilter;
+
+// meshes under data/geo the benchmarks and the conformance check run on
+//
+static const char *objs[] = { "moon-houdini.obj", "lander.obj", "Freigther_BI_Export.obj",
+	"HDU_lowRez_part1.obj", "Intergalactic_Spaceships_Version_2.obj", "burger.obj" };
+static const int numObjs = 6;
+static volatile float sink;
+
+static double nowMs() {
+	return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool selected(const string & name) {
+	return name.compare(0, benchFilter.size(), benchFilter) == 0;
+}
+
+static void report(const string & name, const string & input, const string & param,
+	int iterations, double ms, double value = 0)
+{
+	double ns = iterations > 0 ? ms * 1000000.0 / iterations : 0;
+	cout << name << "," << input << "," << param << "," << iterations << ","
+		<< ms << "," << ns << "," << value << endl;
+}
+
+//--------------------------------------------------------------
+ofMesh makeTerrain(int n, float size) {
+	ofMesh mesh;
+	for (int z = 0; z < n; z++) {
+		for (int x = 0; x < n; x++) {
+			float fx = x * size / (n - 1) - size / 2;
+			float fz = z * size / (n - 1) - size / 2;
+			float y = 8 * sin(fx * 0.03) * cos(fz * 0.04) + 2 * sin(fx * 0.21 + fz * 0.17);
+			mesh.addVertex(glm::vec3(fx, y, fz));
+		}
+	}
+	for (int z = 0; z + 1 < n; z++) {
+		for (int x = 0; x + 1 < n; x++) {
+			int i = z * n + x;
+			mesh.addIndex(i);
+			mesh.addIndex(i + n);
+			mesh.addIndex(i + 1);
+			mesh.addIndex(i + 1);
+			mesh.addIndex(i + n);
+			mesh.addIndex(i + n + 1);
+		}
+	}
+	return mesh;
+}
+
+//--------------------------------------------------------------
+bool loadObjMesh(const string & path, ofMesh & mesh) {
+	ifstream file(path.c_str());
+	if (!file.is_open()) return false;
+
+	mesh.clear();
+	string line;
+	vector<int> face;
+	while (getline(file, line)) {
+		if (line.size() < 2) continue;
+		if (line[0] == 'v' && line[1] == ' ') {
+			glm::vec3 v;
+			istringstream in(line.substr(2));
+			in >> v.x >> v.y >> v.z;
+			mesh.addVertex(v);
+		}
+		else if (line[0] == 'f' && line[1] == ' ') {
+			// "f v/vt/vn ..." - keep the vertex index, fan triangulate
+			//
+			face.clear();
+			istringstream in(line.substr(2));
+			string token;
+			while (in >> token) {
+				int i = atoi(token.c_str());
+				if (i < 0) i += mesh.getNumVertices();
+				else i -= 1;
+				face.push_back(i);
+			}
+			for (int i = 1; i + 1 < int(face.size()); i++) {
+				mesh.addIndex(face[0]);
+				mesh.addIndex(face[i]);
+				mesh.addIndex(face[i + 1]);
+			}
+		}
+	}
+	return mesh.getNumVertices() > 0;
+}
+
+//--------------------------------------------------------------
+//
+//  Octree / BVH
+//
+//--------------------------------------------------------------
+
+// query workload shared by both structures: downward rays over the
+// mesh, lander sized boxes resting on it and the same boxes stretched
+// and yawed at random
+//
+class QuerySet {
+public:
+	vector<Ray> rays;
+	vector<Box> boxes;
+	vector<OBB> obbs;
+};
+
+static QuerySet makeQueries(const ofMesh & mesh, int n) {
+	QuerySet q;
+	Box bounds = Octree::pointBounds(mesh.getVerticesPointer(), mesh.getNumVertices());
+	Vector3 min = bounds.parameters[0];
+	Vector3 max = bounds.parameters[1];
+	Vector3 size = max - min;
+	float boxSize = 0.02 * std::max(size.x(), size.z());
+	for (int i = 0; i < n; i++) {
+		float x = ofRandom(min.x(), max.x());
+		float z = ofRandom(min.z(), max.z());
+		glm::vec3 d = glm::normalize(glm::vec3(ofRandom(-0.2, 0.2), -1, ofRandom(-0.2, 0.2)));
+		q.rays.push_back(Ray(Vector3(x, max.y() + 10, z), Vector3(d.x, d.y, d.z)));
+
+		int v = int(ofRandom(0, mesh.getNumVertices() - 1));
+		glm::vec3 p = mesh.getVertex(v);
+		q.boxes.push_back(Box(Vector3(p.x - boxSize, p.y - boxSize / 2, p.z - boxSize),
+			Vector3(p.x + boxSize, p.y + boxSize * 2, p.z + boxSize)));
+		Box local(Vector3(-boxSize * 2, -boxSize / 2, -boxSize / 2), Vector3(boxSize * 2, boxSize * 2, boxSize / 2));
+		q.obbs.push_back(OBB::fromBox(local, ofRandom(0, 360), Vector3(p.x, p.y, p.z)));
+	}
+	return q;
+}
+
+static void benchIndex(SpatialIndex & index, const string & input, const string & param,
+	const ofMesh & mesh, const QuerySet & q)
+{
+	string name = index.name();
+	if (selected(name + "_build")) {
+		double t1 = nowMs();
+		index.build(mesh);
+		double t2 = nowMs();
+		report(name + "_build", input, param, 1, t2 - t1, index.memoryUsage());
+		report(name + "_bytes_per_vertex", input, param, 1, 0, double(index.memoryUsage()) / mesh.getNumVertices());
+	}
+	else {
+		index.build(mesh);
+	}
+
+	if (selected(name + "_ray")) {
+		glm::vec3 p;
+		int hits = 0;
+		double t1 = nowMs();
+		for (int i = 0; i < int(q.rays.size()); i++) {
+			if (index.rayQuery(q.rays[i], p)) hits++;
+		}
+		double t2 = nowMs();
+		report(name + "_ray", input, param, q.rays.size(), t2 - t1, hits);
+	}
+
+	if (selected(name + "_box")) {
+		vector<Box> boxList;
+		int leaves = 0;
+		double t1 = nowMs();
+		for (int i = 0; i < int(q.boxes.size()); i++) {
+			boxList.clear();
+			index.boxQuery(q.boxes[i], boxList);
+			leaves += boxList.size();
+		}
+		double t2 = nowMs();
+		report(name + "_box", input, param, q.boxes.size(), t2 - t1, leaves);
+	}
+
+	// traversal work per query, counted in a separate untimed pass
+	//
+	if (selected(name + "_visits")) {
+		QueryStats rayStats, boxStats;
+		glm::vec3 p;
+		vector<Box> boxList;
+		for (int i = 0; i < int(q.rays.size()); i++) index.rayQuery(q.rays[i], p, &rayStats);
+		for (int i = 0; i < int(q.boxes.size()); i++) {
+			boxList.clear();
+			index.boxQuery(q.boxes[i], boxList, &boxStats);
+		}
+		report(name + "_visits_ray", input, param, rayStats.queries, 0, double(rayStats.nodesVisited) / max(rayStats.queries, 1));
+		report(name + "_visits_box", input, param, boxStats.queries, 0, double(boxStats.nodesVisited) / max(boxStats.queries, 1));
+	}
+
+	// oriented boxes against their axis aligned bounds:  time, leaves
+	// returned and nodes visited per query
+	//
+	if (selected(name + "_obb")) {
+		vector<Box> boxList;
+		QueryStats obbStats, aabbStats;
+		int leaves = 0;
+		double t1 = nowMs();
+		for (int i = 0; i < int(q.obbs.size()); i++) {
+			boxList.clear();
+			index.boxQuery(q.obbs[i], boxList);
+			leaves += boxList.size();
+		}
+		double t2 = nowMs();
+		report(name + "_obb", input, param, q.obbs.size(), t2 - t1, leaves);
+		for (int i = 0; i < int(q.obbs.size()); i++) {
+			boxList.clear();
+			index.boxQuery(q.obbs[i], boxList, &obbStats);
+			boxList.clear();
+			index.boxQuery(q.obbs[i].bounds(), boxList, &aabbStats);
+		}
+		report(name + "_obb_leaves", input, param, obbStats.queries, 0, double(obbStats.results) / max(obbStats.queries, 1));
+		report(name + "_obb_bounds_leaves", input, param, aabbStats.queries, 0, double(aabbStats.results) / max(aabbStats.queries, 1));
+		report(name + "_obb_visits", input, param, obbStats.queries, 0, double(obbStats.nodesVisited) / max(obbStats.queries, 1));
+		report(name + "_obb_bounds_visits", input, param, aabbStats.queries, 0, double(aabbStats.nodesVisited) / max(aabbStats.queries, 1));
+	}
+
+	// narrow phase under the oriented boxes, with the box itself as the
+	// convex shape:  candidate triangles, then GJK/EPA against each.  The
+	// boxes sit in the terrain, so nearly every candidate is a contact;
+	// the first 500 are plenty.
+	//
+	if (selected(name + "_narrow")) {
+		vector<int> tris;
+		int candidates = 0;
+		int contacts = 0;
+		int n = min(int(q.obbs.size()), 500);
+		double t1 = nowMs();
+		for (int i = 0; i < n; i++) {
+			const OBB & box = q.obbs[i];
+			glm::vec3 corners[8];
+			for (int k = 0; k < 8; k++) {
+				Vector3 c = box.center;
+				for (int j = 0; j < 3; j++) c = c + box.axis[j] * (k & (1 << j) ? box.halfExtents[j] : -box.halfExtents[j]);
+				corners[k] = glm::vec3(c.x(), c.y(), c.z());
+			}
+			tris.clear();
+			index.triangleQuery(box, tris);
+			candidates += tris.size();
+			glm::vec3 tri[3];
+			for (int t = 0; t < int(tris.size()); t++) {
+				index.triangle(tris[t], tri[0], tri[1], tri[2]);
+				Contact contact;
+				if (convexOverlap(corners, 8, tri, 3, &contact)) contacts++;
+			}
+		}
+		double t2 = nowMs();
+		report(name + "_narrow", input, param, n, t2 - t1, contacts);
+		report(name + "_narrow_triangles", input, param, n, 0, double(candidates) / max(n, 1));
+	}
+
+	if (selected(name + "_nearest")) {
+		int found = 0;
+		int point;
+		double t1 = nowMs();
+		for (int i = 0; i < int(q.boxes.size()); i++) {
+			Vector3 c = q.boxes[i].parameters[1];
+			if (index.nearestPoint(glm::vec3(c.x(), c.y(), c.z()), point)) found++;
+		}
+		double t2 = nowMs();
+		report(name + "_nearest", input, param, q.boxes.size(), t2 - t1, found);
+	}
+}
+
+//--------------------------------------------------------------
+//
+//  Heightfield
+//
+//--------------------------------------------------------------
+
+// build on one thread and on all, ground height under the query rays
+// against a straight down BVH ray (value:  mean difference), and the
+// broad phase reject over the query boxes lifted off the ground by 0 to 7
+// box heights (value:  fraction rejected)
+//
+static void benchHeightfield(const ofMesh & mesh, const string & input, const QuerySet & q) {
+	if (!selected("heightfield")) return;
+	Heightfield field;
+	int threads[] = { 1, 0 };
+	for (int i = 0; i < 2; i++) {
+		double t1 = nowMs();
+		field.build(mesh, 512, threads[i]);
+		double t2 = nowMs();
+		string param = threads[i] ? "threads=1" : "threads=" + ofToString(max(1, int(thread::hardware_concurrency())));
+		report("heightfield_build", input, param, 1, t2 - t1,
+			(field.heights.size() + field.cellMin.size() + field.cellMax.size()) * sizeof(float));
+	}
+
+	float top = -FLT_MAX;
+	for (int i = 0; i < int(field.cellMax.size()); i++) top = max(top, field.cellMax[i]);
+	float sum = 0;
+	double t1 = nowMs();
+	for (int i = 0; i < int(q.rays.size()); i++) {
+		Vector3 o = q.rays[i].origin;
+		sum += field.height(o.x(), o.z());
+	}
+	double t2 = nowMs();
+	sink = sum;
+	report("heightfield_height", input, "res=512", q.rays.size(), t2 - t1);
+
+	BVH bvh;
+	bvh.build(mesh);
+	vector<Ray> down;
+	for (int i = 0; i < int(q.rays.size()); i++) {
+		Vector3 o = q.rays[i].origin;
+		down.push_back(Ray(Vector3(o.x(), top + 10, o.z()), Vector3(0, -1, 0)));
+	}
+	double error = 0;
+	int hits = 0;
+	glm::vec3 p;
+	t1 = nowMs();
+	for (int i = 0; i < int(down.size()); i++) {
+		if (bvh.rayQuery(down[i], p)) {
+			error += fabs(p.y - field.height(p.x, p.z));
+			hits++;
+		}
+	}
+	t2 = nowMs();
+	report("heightfield_bvh_vertical", input, "sah", down.size(), t2 - t1, error / max(hits, 1));
+
+	vector<Box> lifted;
+	for (int i = 0; i < int(q.boxes.size()); i++) {
+		Box b = q.boxes[i];
+		Vector3 up(0, (i % 8) * (b.parameters[1].y() - b.parameters[0].y()), 0);
+		lifted.push_back(Box(b.parameters[0] + up, b.parameters[1] + up));
+	}
+	int rejects = 0;
+	t1 = nowMs();
+	for (int i = 0; i < int(lifted.size()); i++) {
+		if (field.above(lifted[i])) rejects++;
+	}
+	t2 = nowMs();
+	report("heightfield_reject", input, "res=512", lifted.size(), t2 - t1, double(rejects) / max(int(lifted.size()), 1));
+}
+
+static void benchMesh(const ofMesh & mesh, const string & input) {
+	QuerySet q = makeQueries(mesh, 10000);
+
+	// fixed level counts, as the app used to build
+	//
+	int levels[] = { 6, 8, 10, 12 };
+	for (int i = 0; i < 4; i++) {
+		Octree octree;
+		octree.bLean = true;
+		octree.maxLevels = levels[i];
+		benchIndex(octree, input, "levels=" + ofToString(levels[i]), mesh, q);
+	}
+
+	// adaptive, as the app builds now
+	//
+	Octree octree;
+	octree.bLean = true;
+	octree.maxLeafPoints = 1;
+	octree.minExtent = 0.05;
+	octree.maxLevels = 20;
+	benchIndex(octree, input, "leaf=1", mesh, q);
+
+	// incremental moves of vertices by a small step, against the full
+	// rebuild they save ("value" is the build time in ms)
+	//
+	if (selected("octree_move") && mesh.getNumVertices() > 0) {
+		Octree moving;
+		moving.maxLeafPoints = 1;
+		moving.minExtent = 0.05;
+		moving.create(mesh, 20);
+		const int n = 10000;
+		double t1 = nowMs();
+		for (int i = 0; i < n; i++) {
+			int v = int((i * 7919LL) % moving.numVertices);
+			glm::vec3 p = moving.vertex(v) + glm::vec3(ofRandom(-0.5, 0.5), ofRandom(-0.5, 0.5), ofRandom(-0.5, 0.5));
+			moving.move(v, ofVec3f(p.x, p.y, p.z));
+		}
+		double t2 = nowMs();
+		report("octree_move", input, "leaf=1", n, t2 - t1, moving.report.buildTime);
+	}
+
+	BVH bvh;
+	benchIndex(bvh, input, "sah", mesh, q);
+
+	benchHeightfield(mesh, input, q);
+}
+
+//--------------------------------------------------------------
+//
+//  Box / particles
+//
+//--------------------------------------------------------------
+
+static void benchBoxIntersect() {
+	if (!selected("box_intersect")) return;
+	const int n = 1000000;
+	vector<Ray> rays;
+	for (int i = 0; i < 1024; i++) {
+		glm::vec3 d = glm::normalize(glm::vec3(ofRandom(-1, 1), ofRandom(-1, 1), ofRandom(-1, 1)));
+		rays.push_back(Ray(Vector3(ofRandom(-20, 20), ofRandom(-20, 20), ofRandom(-20, 20)), Vector3(d.x, d.y, d.z)));
+	}
+	Box box = Box(Vector3(-5, -5, -5), Vector3(5, 5, 5));
+	int hits = 0;
+	double t1 = nowMs();
+	for (int i = 0; i < n; i++) {
+		if (box.intersect(rays[i & 1023], 0, 1000)) hits++;
+	}
+	double t2 = nowMs();
+	report("box_intersect", "random", "", n, t2 - t1, hits);
+}
+
+static void benchParticles() {
+	int counts[] = { 1000, 10000, 100000 };
+	for (int c = 0; c < 3; c++) {
+		if (!selected("particle_update")) break;
+		ParticleSystem sys;
+		GravityForce gravity = GravityForce(ofVec3f(0, -4, 0));
+		TurbulenceForce turbulence = TurbulenceForce(ofVec3f(-10, -10, -10), ofVec3f(10, 10, 10));
+		sys.addForce(&gravity);
+		sys.addForce(&turbulence);
+		Particle p;
+		p.lifespan = -1;
+		for (int i = 0; i < counts[c]; i++) {
+			p.position = ofVec3f(ofRandom(-10, 10), ofRandom(-10, 10), ofRandom(-10, 10));
+			sys.add(p);
+		}
+		const int frames = 50;
+		double t1 = nowMs();
+		for (int f = 0; f < frames; f++) sys.update(1.0 / 60);
+		double t2 = nowMs();
+		sink = sys.particles[0].position.y;
+		report("particle_update", "synthetic", "particles=" + ofToString(counts[c]), frames * counts[c], t2 - t1);
+	}
+
+	if (selected("emitter_spawn")) {
+		EmitterType types[] = { DirectionalEmitter, RadialEmitter };
+		string names[] = { "directional", "radial" };
+		for (int t = 0; t < 2; t++) {
+			ParticleEmitter emitter;
+			emitter.setEmitterType(types[t]);
+			emitter.setVelocity(ofVec3f(0, 10, 0));
+			const int n = 100000;
+			emitter.sys->particles.reserve(n);
+			double t1 = nowMs();
+			for (int i = 0; i < n; i++) emitter.spawn(0);
+			double t2 = nowMs();
+			report("emitter_spawn", "synthetic", names[t], n, t2 - t1, emitter.sys->particles.size());
+		}
+	}
+
+	// whole groups sampled by each shape, through the per type switch
+	//
+	if (selected("emitter_group")) {
+		EmitterType types[] = { DirectionalEmitter, RadialEmitter, SphereEmitter, SphereVolumeEmitter, ConeEmitter, DiskEmitter };
+		string names[] = { "directional", "radial", "sphere", "sphere_volume", "cone", "disk" };
+		for (int t = 0; t < 6; t++) {
+			ParticleEmitter emitter;
+			emitter.setEmitterType(types[t]);
+			emitter.setVelocity(ofVec3f(0, 10, 0));
+			const int n = 100000;
+			const int group = 500;
+			emitter.sys->particles.reserve(n);
+			double t1 = nowMs();
+			for (int i = 0; i < n; i += group) emitter.spawnGroup(0, group);
+			double t2 = nowMs();
+			report("emitter_group", "group=" + ofToString(group), names[t], n, t2 - t1, emitter.sys->particles.size());
+		}
+	}
+	// a continuous emitter with an explosion every 50 steps, under a
+	// budget of 2000, with and without frame time pressure (the frame
+	// time fed in is 2x the target):  time per step and the most
+	// particles alive at once
+	//
+	if (selected("particle_budget")) {
+		for (int pressure = 0; pressure < 2; pressure++) {
+			ParticleEmitter exhaust, explosion;
+			exhaust.setRate(1e6);
+			exhaust.setGroupSize(40);
+			exhaust.setLifespan(1e6);
+			exhaust.start();
+			explosion.setEmitterType(RadialEmitter);
+			explosion.setOneShot(true);
+			explosion.setGroupSize(500);
+			explosion.setLifespan(1e6);
+			ParticleBudget budget;
+			budget.maxParticles = 2000;
+			budget.add(&explosion, 2, 0.5);
+			budget.add(&exhaust, 1, 0.25);
+
+			const int steps = 1000;
+			int peak = 0;
+			double t1 = nowMs();
+			for (int i = 0; i < steps; i++) {
+				if (i % 50 == 0) explosion.start();
+				budget.update(pressure ? budget.targetFrameMs * 2 : budget.targetFrameMs);
+				exhaust.update(1.0 / 120);
+				explosion.update(1.0 / 120);
+				peak = max(peak, budget.total());
+			}
+			double t2 = nowMs();
+			report("particle_budget", "synthetic", pressure ? "pressure" : "no_pressure", steps, t2 - t1, peak);
+		}
+	}
+}
+
+// a spike in frame time (an explosion) and then frames back under the
+// target:  the quality must drop during the spike and get back to 1
+// within twenty seconds of steady frames, for light frames and for
+// frames only just fitting in the target.  "value" is the frames it
+// took, -1 if it never did.
+//
+static bool benchBudgetRecovery() {
+	if (!selected("particle_budget_recovery")) return true;
+	bool ok = true;
+	float works[] = { 8, 16 };
+	for (int w = 0; w < 2; w++) {
+		ParticleBudget budget;
+		for (int i = 0; i < 120; i++) budget.update(works[w]);
+		for (int i = 0; i < 60; i++) budget.update(budget.targetFrameMs * 3);
+		float low = budget.quality;
+		int frames = -1;
+		const int limit = 1200;
+		double t1 = nowMs();
+		for (int i = 0; i < limit && frames < 0; i++) {
+			budget.update(works[w]);
+			if (budget.quality >= 1) frames = i + 1;
+		}
+		double t2 = nowMs();
+		report("particle_budget_recovery", "work=" + ofToString(works[w]) + "ms", "quality=" + ofToString(low, 2), limit, t2 - t1, frames);
+		if (low >= 1 || frames < 0) {
+			cerr << "particle_budget_recovery: quality " << low << " after the spike, " << budget.quality << " after " << limit << " frames of " << works[w] << " ms" << endl;
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+// back to front order of a particle cloud, the radix sort on one thread
+// and on all of them against std::sort of the indices by depth (both
+// include working out the depths).  "value" is the number of neighbours
+// in the wrong order, 0 if the sort is right.
+//
+static void benchDepthSort() {
+	if (!selected("depth_sort")) return;
+	glm::mat4 view(1);
+	view[0][2] = 0.36;
+	view[1][2] = -0.48;
+	view[2][2] = 0.8;
+	view[3][2] = -200;
+	int counts[] = { 10000, 100000, 1000000 };
+	int cores = max(1, int(thread::hardware_concurrency()));
+	for (int c = 0; c < 3; c++) {
+		int n = counts[c];
+		vector<Particle> particles(n);
+		for (int i = 0; i < n; i++) particles[i].position = ofVec3f(ofRandom(-100, 100), ofRandom(-100, 100), ofRandom(-100, 100));
+		vector<float> depth(n);
+		auto misordered = [&](const vector<int> & order) {
+			int bad = 0;
+			for (int i = 1; i < int(order.size()); i++) if (depth[order[i]] > depth[order[i - 1]]) bad++;
+			return bad;
+		};
+		const int reps = max(3, 1000000 / n);
+		string param = "particles=" + ofToString(n);
+
+		vector<int> order(n);
+		double t1 = nowMs();
+		for (int r = 0; r < reps; r++) {
+			for (int i = 0; i < n; i++) {
+				const ofVec3f & p = particles[i].position;
+				depth[i] = -(view[0][2] * p.x + view[1][2] * p.y + view[2][2] * p.z + view[3][2]);
+				order[i] = i;
+			}
+			std::sort(order.begin(), order.end(), [&](int a, int b) { return depth[a] > depth[b]; });
+		}
+		double t2 = nowMs();
+		report("depth_sort", "std_sort", param, reps * n, t2 - t1, misordered(order));
+
+		int threads[] = { 1, cores };
+		for (int k = 0; k < (cores > 1 ? 2 : 1); k++) {
+			DepthSort sort;
+			sort.sort(particles, view, threads[k]);
+			t1 = nowMs();
+			for (int r = 0; r < reps; r++) sort.sort(particles, view, threads[k]);
+			t2 = nowMs();
+			report("depth_sort", "radix", param + " threads=" + ofToString(threads[k]), reps * n, t2 - t1, misordered(sort.order));
+		}
+	}
+}
+
+//--------------------------------------------------------------
+//
+//  Lander soak
+//
+//--------------------------------------------------------------
+
+// the simulation step as the app runs it (see ofApp::prepareFrame and
+// simulate):  forces on the lander body, the exhaust following it with
+// the thruster pulsing, an explosion every ten seconds, both emitters
+// under one particle budget, and the terrain query under the lander
+//
+class SoakSim {
+public:
+	SoakSim() : gravity(ofVec3f(0, -4, 0)), turbulence(ofVec3f(-10, -10, -10), ofVec3f(10, 10, 10)), radial(1000) {
+		exhaust.sys->addForce(&turbulence);
+		exhaust.sys->addForce(&gravity);
+		exhaust.start();
+		explosion.sys->addForce(&turbulence);
+		explosion.sys->addForce(&gravity);
+		explosion.sys->addForce(&radial);
+		explosion.setOneShot(true);
+		explosion.setGroupSize(500);
+		explosion.setVelocity(ofVec3f(100, 100, 100));
+		budget.add(&explosion, 2, 0.5);
+		budget.add(&exhaust, 1, 0.25);
+
+		terrain = makeTerrain(128, 400);
+		octree.bLean = true;
+		octree.maxLeafPoints = 1;
+		octree.minExtent = 0.05;
+		octree.create(terrain, 20);
+		body.reset(glm::vec3(0, 100, 100));
+	}
+
+	void step(int i, float dt) {
+		float t = i * dt;
+		body.addForce(glm::vec3(0, -4, 0) * body.mass);
+		body.addForce(glm::vec3(threadRandom(-10, 10), threadRandom(-10, 10), threadRandom(-10, 10)));
+		body.addForce((glm::vec3(0, 4 + 2 * sin(t * 0.3), 0) + body.heading()) * body.mass);
+		body.addTorque(sin(t * 0.5) * body.mass);
+
+		// the game's default lifespan, rate and velocity; particles age on
+		// the step clock, so the counts don't depend on how fast the
+		// steps run
+		//
+		bool thruster = (i / 120) % 2 == 0;
+		ofVec3f position = ofVec3f(body.position.x, body.position.y, body.position.z);
+		exhaust.setPosition(position);
+		exhaust.setVelocity(ofVec3f(0, -10, 0));
+		exhaust.setLifespan(thruster ? 3 : 0);
+		exhaust.setRate(thruster ? 100 : 0);
+		explosion.setPosition(position);
+		explosion.setLifespan(3);
+		if (i % 600 == 0) {
+			explosion.sys->reset();
+			explosion.start();
+		}
+
+		// no frame time (the quality stays at 1), so neither do the
+		// particle counts depend on the machine
+		//
+		budget.update(0);
+
+		body.integrate(dt);
+		exhaust.update(dt);
+		explosion.update(dt);
+
+		Box local = Box(Vector3(-2, 0, -2), Vector3(2, 3, 2));
+		OBB box = OBB::fromBox(local, body.rotation, Vector3(body.position.x, body.position.y, body.position.z));
+		boxes.clear();
+		octree.boxQuery(box, boxes);
+		if (body.position.y < -20) body.reset(glm::vec3(0, 100, 100));
+	}
+
+	int particles() const { return budget.total(); }
+
+	LanderBody body;
+	GravityForce gravity;
+	TurbulenceForce turbulence;
+	ImpulseRadialForce radial;
+	ShapeEmitter<ConeShape> exhaust;
+	ShapeEmitter<RadialShape> explosion;
+	ParticleBudget budget;
+	ofMesh terrain;
+	Octree octree;
+	vector<Box> boxes;
+};
+
+// minutes of simulated flight, timed per minute ("value" is the most
+// particles alive at once in that minute).  A long session must cost
+// what a short one does:  the last three minutes may cost no more than
+// 25% over the first three (the fastest of each, to ride out timer
+// noise), and may not peak above the first three's particle count (the
+// counts are the same on every machine) nor above the budget.
+// The old lander (a particle emitter gaining an immortal particle every
+// step) runs alongside for two minutes for comparison.
+//
+static bool benchSoak() {
+	if (!selected("lander_soak")) return true;
+	const float dt = 1.0 / 60;
+	const int stepsPerMinute = 3600;
+	const int minutes = 10;
+
+	SoakSim sim;
+	vector<double> ms(minutes);
+	vector<int> peak(minutes);
+	for (int m = 0; m < minutes; m++) {
+		double t1 = nowMs();
+		for (int i = 0; i < stepsPerMinute; i++) {
+			sim.step(m * stepsPerMinute + i, dt);
+			peak[m] = max(peak[m], sim.particles());
+		}
+		double t2 = nowMs();
+		ms[m] = t2 - t1;
+		report("lander_soak", "step", "minute=" + ofToString(m + 1), stepsPerMinute, ms[m], peak[m]);
+	}
+	sink = sim.body.position.y;
+
+	GravityForce gravity = GravityForce(ofVec3f(0, -4, 0));
+	TurbulenceForce turbulence = TurbulenceForce(ofVec3f(-10, -10, -10), ofVec3f(10, 10, 10));
+	ParticleEmitter oldLander;
+	oldLander.sys->addForce(&gravity);
+	oldLander.sys->addForce(&turbulence);
+	oldLander.setPosition(ofVec3f(0, 100, 100));
+	oldLander.setLifespan(-1);
+	oldLander.setRate(0);
+	for (int m = 0; m < 2; m++) {
+		double t1 = nowMs();
+		for (int i = 0; i < stepsPerMinute; i++) {
+			oldLander.spawn(0);
+			oldLander.update(dt);
+		}
+		double t2 = nowMs();
+		report("lander_soak", "emitter", "minute=" + ofToString(m + 1), stepsPerMinute, t2 - t1, oldLander.sys->particles.size());
+	}
+
+	double first = *min_element(ms.begin(), ms.begin() + 3);
+	double last = *min_element(ms.end() - 3, ms.end());
+	int firstPeak = *max_element(peak.begin(), peak.begin() + 3);
+	int lastPeak = *max_element(peak.end() - 3, peak.end());
+	report("lander_soak_growth", "step", "last/first", minutes * stepsPerMinute, 0, first > 0 ? last / first : 0);
+	bool ok = true;
+	if (last > first * 1.25) {
+		cerr << "lander_soak: step cost grew from " << first << " ms to " << last << " ms per minute" << endl;
+		ok = false;
+	}
+	if (lastPeak > firstPeak || lastPeak > sim.budget.maxParticles) {
+		cerr << "lander_soak: particles peaked at " << lastPeak << " late in the flight, " << firstPeak << " early on" << endl;
+		ok = false;
+	}
+	return ok;
+}
+
+//--------------------------------------------------------------
+//
+//  Concurrent query stress
+//
+//--------------------------------------------------------------
+
+// results of every query in a QuerySet, run on one thread to check the
+// concurrent runs against
+//
+class QueryResults {
+public:
+	vector<char> rayHit;
+	vector<glm::vec3> rayPoint;
+	vector<vector<Box>> boxes;
+	vector<int> nearest;
+	QueryStats stats;
+};
+
+static bool sameBox(const Box & a, const Box & b) {
+	for (int i = 0; i < 2; i++) {
+		if (a.parameters[i].x() != b.parameters[i].x() ||
+			a.parameters[i].y() != b.parameters[i].y() ||
+			a.parameters[i].z() != b.parameters[i].z()) return false;
+	}
+	return true;
+}
+
+static void runQueries(const SpatialIndex & index, const QuerySet & q, QueryResults & r) {
+	int n = q.rays.size();
+	r.rayHit.resize(n);
+	r.rayPoint.resize(n);
+	r.boxes.resize(n);
+	r.nearest.resize(n);
+	for (int i = 0; i < n; i++) {
+		r.rayHit[i] = index.rayQuery(q.rays[i], r.rayPoint[i], &r.stats);
+		index.boxQuery(q.boxes[i], r.boxes[i], &r.stats);
+		Vector3 c = q.boxes[i].parameters[1];
+		if (!index.nearestPoint(glm::vec3(c.x(), c.y(), c.z()), r.nearest[i], &r.stats)) r.nearest[i] = -1;
+	}
+}
+
+// one worker:  passes over the whole set in its own order (stride
+// coprime to the set size), results in its own buffers, compared to
+// the reference as it goes.  Returns the number of mismatches.
+//
+static int stressWorker(const SpatialIndex & index, const QuerySet & q, const QueryResults & ref,
+	int passes, int seed, QueryStats & statsRtn)
+{
+	int n = q.rays.size();
+	int stride = 1 + 2 * (seed % 97);
+	auto gcd = [](int a, int b) { while (b) { int t = a % b; a = b; b = t; } return a; };
+	while (gcd(n, stride) != 1) stride += 2;
+	int errors = 0;
+	glm::vec3 p;
+	vector<Box> boxList;
+	for (int pass = 0; pass < passes; pass++) {
+		for (int j = 0; j < n; j++) {
+			int i = (seed * 7919 + j * stride) % n;
+			bool hit = index.rayQuery(q.rays[i], p, &statsRtn);
+			if (hit != bool(ref.rayHit[i]) || (hit && p != ref.rayPoint[i])) errors++;
+
+			boxList.clear();
+			index.boxQuery(q.boxes[i], boxList, &statsRtn);
+			if (boxList.size() != ref.boxes[i].size()) errors++;
+			else {
+				for (int k = 0; k < int(boxList.size()); k++) {
+					if (!sameBox(boxList[k], ref.boxes[i][k])) { errors++; break; }
+				}
+			}
+
+			int point = -1;
+			Vector3 c = q.boxes[i].parameters[1];
+			if (!index.nearestPoint(glm::vec3(c.x(), c.y(), c.z()), point, &statsRtn)) point = -1;
+			if (point != ref.nearest[i]) errors++;
+		}
+	}
+	return errors;
+}
+
+static int stressIndex(SpatialIndex & index, const string & input, const ofMesh & mesh,
+	const QuerySet & q, int numThreads)
+{
+	const int passes = 4;
+	index.build(mesh);
+	QueryResults ref;
+	runQueries(index, q, ref);
+
+	// all threads share the one index, built above and not touched again
+	//
+	const SpatialIndex & shared = index;
+	vector<thread> threads;
+	vector<QueryStats> stats(numThreads);
+	atomic<int> errors(0);
+	double t1 = nowMs();
+	for (int t = 0; t < numThreads; t++) {
+		threads.push_back(thread([&, t]() {
+			errors += stressWorker(shared, q, ref, passes, t + 1, stats[t]);
+		}));
+	}
+	for (int t = 0; t < int(threads.size()); t++) threads[t].join();
+	double t2 = nowMs();
+
+	// same queries, so the work counted must add up exactly too
+	//
+	QueryStats total;
+	for (int t = 0; t < numThreads; t++) total.add(stats[t]);
+	long expected = long(ref.stats.nodesVisited) * passes * numThreads;
+	if (total.nodesVisited != expected || total.queries != ref.stats.queries * passes * numThreads) errors++;
+
+	int queries = numThreads * passes * q.rays.size() * 3;
+	report(index.name() + "_stress", input, "threads=" + ofToString(numThreads), queries, t2 - t1, errors.load());
+	return errors.load();
+}
+
+//--------------------------------------------------------------
+int runStress(int numThreads) {
+	if (numThreads < 1) numThreads = max(2, int(thread::hardware_concurrency()));
+	cout << fixed << setprecision(3);
+	cout << "benchmark,input,param,iterations,total_ms,ns_per_op,value" << endl;
+
+	ofMesh mesh = makeTerrain(256, 400);
+	QuerySet q = makeQueries(mesh, 2000);
+	int errors = 0;
+
+	Octree octree;
+	octree.bLean = true;
+	octree.maxLeafPoints = 1;
+	octree.minExtent = 0.05;
+	octree.maxLevels = 20;
+	errors += stressIndex(octree, "terrain256", mesh, q, numThreads);
+
+	BVH bvh;
+	errors += stressIndex(bvh, "terrain256", mesh, q, numThreads);
+
+	if (errors > 0) cerr << "stress: " << errors << " results differ from the single threaded run" << endl;
+	return errors > 0 ? 1 : 0;
+}
+
+//--------------------------------------------------------------
+//
+//  Conformance
+//
+//--------------------------------------------------------------
+
+// brute force answers over every vertex and triangle of the mesh, the
+// reference both backends are checked against.  Triangles are numbered
+// as the backends number them:  by the mesh's indices, or consecutive
+// vertices for a mesh without.
+//
+class MeshReference {
+public:
+	MeshReference(const ofMesh & mesh) {
+		vertices = mesh.getVertices();
+		if (mesh.getNumIndices() > 0) {
+			int n = mesh.getNumIndices() / 3 * 3;
+			for (int i = 0; i < n; i++) faces.push_back(mesh.getIndex(i));
+		}
+		else {
+			for (int i = 0; i + 2 < int(vertices.size()); i += 3) {
+				faces.push_back(i);
+				faces.push_back(i + 1);
+				faces.push_back(i + 2);
+			}
+		}
+		used.assign(vertices.size(), 0);
+		for (int i = 0; i < int(faces.size()); i++) used[faces[i]] = 1;
+	}
+
+	// closest triangle hit along the ray (Moller-Trumbore)
+	//
+	bool ray(const Ray & ray, glm::vec3 & pointRtn) const {
+		glm::vec3 o = glm::vec3(ray.origin.x(), ray.origin.y(), ray.origin.z());
+		glm::vec3 d = glm::vec3(ray.direction.x(), ray.direction.y(), ray.direction.z());
+		float tBest = FLT_MAX;
+		for (int i = 0; i < int(faces.size()); i += 3) {
+			glm::vec3 a = vertices[faces[i]];
+			glm::vec3 e1 = vertices[faces[i + 1]] - a;
+			glm::vec3 e2 = vertices[faces[i + 2]] - a;
+			glm::vec3 p = glm::cross(d, e2);
+			float det = glm::dot(e1, p);
+			if (fabs(det) < 1e-12) continue;
+			glm::vec3 s = o - a;
+			float u = glm::dot(s, p) / det;
+			if (u < 0 || u > 1) continue;
+			glm::vec3 q = glm::cross(s, e1);
+			float v = glm::dot(d, q) / det;
+			if (v < 0 || u + v > 1) continue;
+			float t = glm::dot(e2, q) / det;
+			if (t >= 0 && t < tBest) tBest = t;
+		}
+		if (tBest == FLT_MAX) return false;
+		pointRtn = o + d * tBest;
+		return true;
+	}
+
+	// squared distances of the k triangle vertices nearest p, nearest first
+	//
+	void nearest(const glm::vec3 & p, int k, vector<float> & d2Rtn) const {
+		d2Rtn.clear();
+		for (int i = 0; i < int(vertices.size()); i++) {
+			if (used[i]) d2Rtn.push_back(glm::dot(vertices[i] - p, vertices[i] - p));
+		}
+		k = std::min(k, int(d2Rtn.size()));
+		partial_sort(d2Rtn.begin(), d2Rtn.begin() + k, d2Rtn.end());
+		d2Rtn.resize(k);
+	}
+
+	// triangles whose bounds overlap box, in order
+	//
+	void triangles(const OBB & box, vector<int> & trianglesRtn) const {
+		trianglesRtn.clear();
+		for (int i = 0; i < int(faces.size()); i += 3) {
+			glm::vec3 a = vertices[faces[i]], b = vertices[faces[i + 1]], c = vertices[faces[i + 2]];
+			glm::vec3 min = glm::min(a, glm::min(b, c));
+			glm::vec3 max = glm::max(a, glm::max(b, c));
+			if (box.overlap(Box(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z)))) trianglesRtn.push_back(i / 3);
+		}
+	}
+
+	vector<glm::vec3> vertices;
+	vector<int> faces;
+	vector<char> used;        // vertex is a triangle corner
+};
+
+// a box query is right if every box it returns overlaps the query and
+// every triangle vertex inside the query is inside one of them
+//
+template <class Query>
+static bool boxQueryConforms(const MeshReference & ref, const Query & query, const vector<Box> & boxes) {
+	for (int i = 0; i < int(boxes.size()); i++) {
+		if (!query.overlap(boxes[i])) return false;
+	}
+	for (int i = 0; i < int(ref.vertices.size()); i++) {
+		Vector3 v = Vector3(ref.vertices[i].x, ref.vertices[i].y, ref.vertices[i].z);
+		if (!ref.used[i] || !query.inside(v)) continue;
+		bool covered = false;
+		for (int k = 0; k < int(boxes.size()) && !covered; k++) covered = boxes[k].inside(v);
+		if (!covered) return false;
+	}
+	return true;
+}
+
+static bool sameDistance(float a, float b) {
+	return fabs(a - b) <= 1e-5 * std::max(1.0f, std::max(a, b));
+}
+
+// every query of the set against the brute force answer, one row per
+// query kind ("value" is the number of wrong answers)
+//
+static int conformIndex(SpatialIndex & index, const string & input, const ofMesh & mesh,
+	const MeshReference & ref, const QuerySet & q)
+{
+	index.build(mesh);
+	int n = q.rays.size();
+	int total = 0;
+	vector<Box> boxes;
+	vector<int> tris, refTris;
+	vector<float> refD2;
+
+	int errors = 0;
+	double t1 = nowMs();
+	for (int i = 0; i < n; i++) {
+		boxes.clear();
+		index.boxQuery(q.boxes[i], boxes);
+		if (!boxQueryConforms(ref, q.boxes[i], boxes)) errors++;
+	}
+	report(index.name() + "_conformance", input, "box", n, nowMs() - t1, errors);
+	total += errors;
+
+	errors = 0;
+	t1 = nowMs();
+	for (int i = 0; i < n; i++) {
+		boxes.clear();
+		index.boxQuery(q.obbs[i], boxes);
+		if (!boxQueryConforms(ref, q.obbs[i], boxes)) errors++;
+	}
+	report(index.name() + "_conformance", input, "obb", n, nowMs() - t1, errors);
+	total += errors;
+
+	errors = 0;
+	t1 = nowMs();
+	for (int i = 0; i < n; i++) {
+		tris.clear();
+		index.triangleQuery(q.obbs[i], tris);
+		sort(tris.begin(), tris.end());
+		ref.triangles(q.obbs[i], refTris);
+		if (tris != refTris) errors++;
+	}
+	report(index.name() + "_conformance", input, "triangles", n, nowMs() - t1, errors);
+	total += errors;
+
+	errors = 0;
+	t1 = nowMs();
+	for (int i = 0; i < n; i++) {
+		glm::vec3 p, refP;
+		bool hit = index.rayQuery(q.rays[i], p);
+		bool refHit = ref.ray(q.rays[i], refP);
+		if (hit != refHit || (hit && glm::length(p - refP) > 1e-3 * std::max(1.0f, glm::length(refP)))) errors++;
+	}
+	report(index.name() + "_conformance", input, "ray", n, nowMs() - t1, errors);
+	total += errors;
+
+	errors = 0;
+	t1 = nowMs();
+	for (int i = 0; i < n; i++) {
+		Vector3 c = q.boxes[i].parameters[1];
+		glm::vec3 p = glm::vec3(c.x(), c.y(), c.z());
+		int point = -1;
+		ref.nearest(p, 1, refD2);
+		if (!index.nearestPoint(p, point) || point < 0 || point >= int(ref.vertices.size()) ||
+			!sameDistance(glm::dot(ref.vertices[point] - p, ref.vertices[point] - p), refD2[0])) errors++;
+	}
+	report(index.name() + "_conformance", input, "nearest", n, nowMs() - t1, errors);
+	total += errors;
+	return total;
+}
+
+// Octree::knn against the k nearest triangle vertices
+//
+static int conformKnn(const Octree & octree, const string & input, const MeshReference & ref, const QuerySet & q) {
+	const int k = 8;
+	int n = q.boxes.size();
+	int errors = 0;
+	vector<int> points;
+	vector<float> refD2;
+	double t1 = nowMs();
+	for (int i = 0; i < n; i++) {
+		Vector3 c = q.boxes[i].parameters[1];
+		glm::vec3 p = glm::vec3(c.x(), c.y(), c.z());
+		octree.knn(p, k, points);
+		ref.nearest(p, k, refD2);
+		bool ok = points.size() == refD2.size();
+		for (int j = 0; ok && j < int(points.size()); j++) {
+			ok = sameDistance(glm::dot(octree.vertex(points[j]) - p, octree.vertex(points[j]) - p), refD2[j]);
+		}
+		if (!ok) errors++;
+	}
+	report("octree_conformance", input, "knn=" + ofToString(k), n, nowMs() - t1, errors);
+	return errors;
+}
+
+static int conformMesh(const ofMesh & mesh, const string & input, int numQueries) {
+	MeshReference ref(mesh);
+	QuerySet q = makeQueries(mesh, numQueries);
+	int errors = 0;
+
+	Octree octree;
+	octree.bLean = true;
+	octree.maxLeafPoints = 1;
+	octree.minExtent = 0.05;
+	octree.maxLevels = 20;
+	errors += conformIndex(octree, input, mesh, ref, q);
+	errors += conformKnn(octree, input, ref, q);
+
+	BVH bvh;
+	errors += conformIndex(bvh, input, mesh, ref, q);
+	return errors;
+}
+
+//--------------------------------------------------------------
+int runConformance() {
+	cout << fixed << setprecision(3);
+	cout << "benchmark,input,param,iterations,total_ms,ns_per_op,value" << endl;
+
+	int errors = conformMesh(makeTerrain(128, 400), "terrain128", 1000);
+	for (int i = 0; i < numObjs; i++) {
+		ofMesh mesh;
+		if (!loadObjMesh(ofToDataPath(string("geo/") + objs[i], true), mesh)) {
+			cerr << "conformance: skipping missing mesh geo/" << objs[i] << endl;
+			continue;
+		}
+		errors += conformMesh(mesh, objs[i], 200);
+	}
+
+	if (errors > 0) cerr << "conformance: " << errors << " results differ from the brute force answers" << endl;
+	return errors > 0 ? 1 : 0;
+}
+
+//--------------------------------------------------------------
+int runBenchmarks(const string & filter) {
+	benchFilter = filter;
+	cout << fixed << setprecision(3);
+	cout << "benchmark,input,param,iterations,total_ms,ns_per_op,value" << endl;
+
+	benchBoxIntersect();
+	benchParticles();
+	bool budgetOk = benchBudgetRecovery();
+	benchDepthSort();
+	bool soakOk = benchSoak();
+
+	benchMesh(makeTerrain(256, 400), "terrain256");
+	benchMesh(makeTerrain(512, 400), "terrain512");
+
+	for (int i = 0; i < numObjs; i++) {
+		ofMesh mesh;
+		if (!loadObjMesh(ofToDataPath(string("geo/") + objs[i], true), mesh)) {
+			cerr << "benchmark: skipping missing mesh geo/" << objs[i] << endl;
+			continue;
+		}
+		benchMesh(mesh, objs[i]);
+	}
+	return budgetOk && soakOk ? 0 : 1;
+}
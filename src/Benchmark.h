@@ -0,0 +1,43 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  Benchmark
+//
+//  Description:
+//  Headless benchmarks for the collision and particle hot paths.
+//  Run the app with --bench (no window is opened); results are
+//  printed as CSV so two builds can be diffed.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+
+// run all benchmarks, or only those whose name starts with filter.
+// Non zero if a check fails (lander_soak:  step cost or particle count
+// growing over a long flight).
+//
+int runBenchmarks(const string & filter);
+
+// run the octree and BVH queries from numThreads threads at once against
+// one shared index (0 = one per core) and check every result against a
+// single threaded run.  Non zero if any differ; build with
+// -fsanitize=thread to also catch data races.
+//
+int runStress(int numThreads);
+
+// check the octree and BVH against brute force answers over every vertex
+// and triangle:  box and oriented box queries, triangle queries, rays,
+// nearest point and the octree's knn, on synthetic terrain and the
+// data/geo meshes.  Non zero if any answer differs.
+//
+int runConformance();
+
+// load the vertex positions and faces of a Wavefront OBJ (no materials),
+// false if the file can't be read
+//
+bool loadObjMesh(const string & path, ofMesh & mesh);
+
+// synthetic rolling terrain, n x n vertices over size x size units
+//
+ofMesh makeTerrain(int n, float size);
@@ -0,0 +1,196 @@
+//--------------------------------------------------------------
+//
+//  ConvexHull
+//
+//--------------------------------------------------------------
+
+#include "ConvexHull.h"
+#include <set>
+
+// quickhull face:  plane dot(normal, p) = dist, and the points still
+// outside it
+//
+class HullFace {
+public:
+	int v[3];
+	glm::vec3 normal;
+	float dist;
+	vector<int> outside;
+	bool dead = false;
+};
+
+static float length2(const glm::vec3 & v) {
+	return glm::dot(v, v);
+}
+
+static HullFace makeFace(const glm::vec3 * points, int a, int b, int c) {
+	HullFace f;
+	f.v[0] = a;
+	f.v[1] = b;
+	f.v[2] = c;
+	f.normal = glm::normalize(glm::cross(points[b] - points[a], points[c] - points[a]));
+	f.dist = glm::dot(f.normal, points[a]);
+	return f;
+}
+
+// put point p on the outside list of the first face it is in front of,
+// and return that face (-1 if none:  p is inside)
+//
+static int assign(vector<HullFace> & faces, const glm::vec3 * points, int p, float eps) {
+	for (int i = 0; i < int(faces.size()); i++) {
+		if (faces[i].dead) continue;
+		if (glm::dot(faces[i].normal, points[p]) - faces[i].dist > eps) {
+			faces[i].outside.push_back(p);
+			return i;
+		}
+	}
+	return -1;
+}
+
+void ConvexHull::build(const glm::vec3 * points, int n) {
+	clear();
+	if (n < 1) return;
+
+	min = max = points[0];
+	for (int i = 1; i < n; i++) {
+		min = glm::min(min, points[i]);
+		max = glm::max(max, points[i]);
+	}
+	float eps = 1e-5 * std::max(1.0f, glm::length(max - min));
+
+	// initial tetrahedron:  the two extreme points furthest apart, the
+	// point furthest from their line and the point furthest from the
+	// plane of those three
+	//
+	int extremes[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < n; i++) {
+		for (int k = 0; k < 3; k++) {
+			if (points[i][k] < points[extremes[k * 2]][k]) extremes[k * 2] = i;
+			if (points[i][k] > points[extremes[k * 2 + 1]][k]) extremes[k * 2 + 1] = i;
+		}
+	}
+	int i0 = 0, i1 = 0;
+	float best = 0;
+	for (int i = 0; i < 6; i++) {
+		for (int j = i + 1; j < 6; j++) {
+			float d = length2(points[extremes[i]] - points[extremes[j]]);
+			if (d > best) { best = d; i0 = extremes[i]; i1 = extremes[j]; }
+		}
+	}
+	int i2 = -1;
+	best = eps * eps;
+	glm::vec3 line = points[i1] - points[i0];
+	for (int i = 0; i < n; i++) {
+		float d = length2(glm::cross(points[i] - points[i0], line));
+		if (d > best * length2(line)) { best = d / length2(line); i2 = i; }
+	}
+	int i3 = -1;
+	if (i2 >= 0) {
+		glm::vec3 normal = glm::normalize(glm::cross(points[i1] - points[i0], points[i2] - points[i0]));
+		best = eps;
+		for (int i = 0; i < n; i++) {
+			float d = fabs(glm::dot(normal, points[i] - points[i0]));
+			if (d > best) { best = d; i3 = i; }
+		}
+	}
+
+	// no volume:  keep the points, their support points are still right
+	//
+	if (i3 < 0) {
+		vertices.assign(points, points + n);
+		return;
+	}
+
+	vector<HullFace> hull;
+	glm::vec3 inside = (points[i0] + points[i1] + points[i2] + points[i3]) * 0.25f;
+	int tet[4][3] = { { i0, i1, i2 }, { i0, i3, i1 }, { i1, i3, i2 }, { i2, i3, i0 } };
+	for (int i = 0; i < 4; i++) {
+		HullFace f = makeFace(points, tet[i][0], tet[i][1], tet[i][2]);
+		if (glm::dot(f.normal, inside) - f.dist > 0) f = makeFace(points, tet[i][0], tet[i][2], tet[i][1]);
+		hull.push_back(f);
+	}
+	for (int i = 0; i < n; i++) {
+		if (i == i0 || i == i1 || i == i2 || i == i3) continue;
+		assign(hull, points, i, eps);
+	}
+
+	// add the furthest outside point of a face at a time:  remove the
+	// faces it can see and close the hole with a fan from the horizon
+	//
+	for (int f = 0; f < int(hull.size()); f++) {
+		if (hull[f].dead || hull[f].outside.empty()) continue;
+		int eye = hull[f].outside[0];
+		float furthest = -1;
+		for (int i = 0; i < int(hull[f].outside.size()); i++) {
+			int p = hull[f].outside[i];
+			float d = glm::dot(hull[f].normal, points[p]) - hull[f].dist;
+			if (d > furthest) { furthest = d; eye = p; }
+		}
+
+		vector<int> visible;
+		set<pair<int, int>> edges;
+		for (int i = 0; i < int(hull.size()); i++) {
+			if (hull[i].dead) continue;
+			if (i == f || glm::dot(hull[i].normal, points[eye]) - hull[i].dist > 0) {
+				visible.push_back(i);
+				for (int k = 0; k < 3; k++) edges.insert(make_pair(hull[i].v[k], hull[i].v[(k + 1) % 3]));
+			}
+		}
+
+		vector<int> orphans;
+		for (int i = 0; i < int(visible.size()); i++) {
+			HullFace & face = hull[visible[i]];
+			face.dead = true;
+			for (int k = 0; k < int(face.outside.size()); k++) {
+				if (face.outside[k] != eye) orphans.push_back(face.outside[k]);
+			}
+			face.outside.clear();
+		}
+
+		// horizon:  edges of the visible faces not shared with another
+		// visible face (its twin runs the other way)
+		//
+		for (auto e = edges.begin(); e != edges.end(); e++) {
+			if (edges.count(make_pair(e->second, e->first))) continue;
+			hull.push_back(makeFace(points, e->first, e->second, eye));
+		}
+
+		// the orphans may also be in front of an older face, which then
+		// needs another visit
+		//
+		int next = f;
+		for (int i = 0; i < int(orphans.size()); i++) {
+			int face = assign(hull, points, orphans[i], eps);
+			if (face >= 0) next = std::min(next, face - 1);
+		}
+		f = next;
+	}
+
+	// compact:  live faces, indexed into the vertices they use
+	//
+	vector<int> remap(n, -1);
+	for (int i = 0; i < int(hull.size()); i++) {
+		if (hull[i].dead) continue;
+		for (int k = 0; k < 3; k++) {
+			int v = hull[i].v[k];
+			if (remap[v] < 0) {
+				remap[v] = vertices.size();
+				vertices.push_back(points[v]);
+			}
+			faces.push_back(remap[v]);
+		}
+	}
+}
+
+const glm::vec3 & ConvexHull::support(const glm::vec3 & d) const {
+	int best = 0;
+	float bestDot = glm::dot(vertices[0], d);
+	for (int i = 1; i < int(vertices.size()); i++) {
+		float dot = glm::dot(vertices[i], d);
+		if (dot > bestDot) {
+			bestDot = dot;
+			best = i;
+		}
+	}
+	return vertices[best];
+}
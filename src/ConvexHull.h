@@ -0,0 +1,35 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  ConvexHull
+//
+//  Description:
+//  Convex hull of a point set (quickhull), built once at load
+//  time for each lander sub-mesh.  The narrow phase (see
+//  Narrowphase.h) only ever asks a hull for its support point,
+//  the vertex furthest along a direction, so a hull of a few
+//  dozen vertices stands in for a sub-mesh of thousands.
+//
+//  Point sets that are flat, a line or a single point have no
+//  3D hull; their points are kept as they are, which still
+//  gives the right support points.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+
+class ConvexHull {
+public:
+	void build(const glm::vec3 * points, int n);
+	void build(const ofMesh & mesh) { build(mesh.getVerticesPointer(), mesh.getNumVertices()); }
+	void clear() { vertices.clear(); faces.clear(); }
+
+	// vertex furthest along d
+	//
+	const glm::vec3 & support(const glm::vec3 & d) const;
+
+	vector<glm::vec3> vertices;
+	vector<int> faces;              // 3 vertex indices per triangle, counter-clockwise seen from outside
+	glm::vec3 min, max;             // bounds of vertices
+};
@@ -0,0 +1,179 @@
+//--------------------------------------------------------------
+//
+//  DepthSort
+//
+//--------------------------------------------------------------
+
+#include "DepthSort.h"
+#include <cstring>
+
+void DepthSort::Barrier::wait() {
+	unique_lock<mutex> l(lock);
+	int g = generation;
+	if (++waiting == count) {
+		waiting = 0;
+		generation++;
+		wake.notify_all();
+		return;
+	}
+	wake.wait(l, [&] { return generation != g; });
+}
+
+// depthKey:  float bits made to compare as unsigned (negative values have
+// all their bits flipped, positive ones the sign bit), then inverted so
+// that the deepest point has the smallest key
+//
+uint32_t DepthSort::depthKey(float depth) {
+	uint32_t u;
+	memcpy(&u, &depth, sizeof(u));
+	u = (u & 0x80000000) ? ~u : (u | 0x80000000);
+	return ~u;
+}
+
+const vector<int> & DepthSort::sort(const Particle * particles, int n, const glm::mat4 & view, int numThreads) {
+	numKeys = n;
+	keys.resize(n);
+	tmpKeys.resize(n);
+	order.resize(n);
+	tmpIndices.resize(n);
+	this->particles = particles;
+	this->view = view;
+	bMakeKeys = true;
+	run(numThreads);
+	this->particles = NULL;
+	return order;
+}
+
+void DepthSort::sortKeys(vector<uint32_t> & userKeys, vector<int> & userIndices, int numThreads) {
+	keys.swap(userKeys);
+	order.swap(userIndices);
+	numKeys = keys.size();
+	tmpKeys.resize(numKeys);
+	tmpIndices.resize(numKeys);
+	bMakeKeys = false;
+	run(numThreads);
+	keys.swap(userKeys);
+	order.swap(userIndices);
+}
+
+DepthSort::~DepthSort() {
+	{
+		lock_guard<mutex> guard(poolLock);
+		bQuit = true;
+	}
+	poolWake.notify_all();
+	for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+}
+
+void DepthSort::run(int threads) {
+	if (threads < 1) threads = std::max(1, int(thread::hardware_concurrency()));
+	if (numKeys < parallelThreshold) threads = 1;
+	numThreads = threads;
+	counts.resize(numThreads * 256);
+	bResultInTmp = false;
+	barrier.reset(numThreads);
+
+	// the pool only grows; workers past numThreads sit this sort out
+	//
+	while (int(workers.size()) < numThreads - 1) {
+		workers.push_back(thread(&DepthSort::workerThread, this, int(workers.size()) + 1, generation));
+	}
+	if (numThreads > 1) {
+		lock_guard<mutex> guard(poolLock);
+		busy = numThreads - 1;
+		generation++;
+	}
+	poolWake.notify_all();
+	radixThread(0);
+	if (numThreads > 1) {
+		unique_lock<mutex> guard(poolLock);
+		poolDone.wait(guard, [this] { return busy == 0; });
+	}
+
+	// an odd number of passes ran, the result is in the other buffers
+	//
+	if (bResultInTmp) {
+		keys.swap(tmpKeys);
+		order.swap(tmpIndices);
+	}
+}
+
+// workerThread:  sort slice t each time the generation moves on from the
+// one the worker has seen
+//
+void DepthSort::workerThread(int t, int seen) {
+	while (true) {
+		{
+			unique_lock<mutex> guard(poolLock);
+			poolWake.wait(guard, [&] { return bQuit || generation != seen; });
+			if (bQuit) return;
+			seen = generation;
+			if (t >= numThreads) continue;
+		}
+		radixThread(t);
+		lock_guard<mutex> guard(poolLock);
+		if (--busy == 0) poolDone.notify_one();
+	}
+}
+
+// makeKeys:  view space depth of this thread's slice (the camera looks
+// down -z, so depth is -z)
+//
+void DepthSort::makeKeys(int t) {
+	float m0 = view[0][2], m1 = view[1][2], m2 = view[2][2], m3 = view[3][2];
+	for (int i = sliceBegin(t); i < sliceEnd(t); i++) {
+		const ofVec3f & p = particles[i].position;
+		keys[i] = depthKey(-(m0 * p.x + m1 * p.y + m2 * p.z + m3));
+		order[i] = i;
+	}
+}
+
+// radixThread:  thread t's share of the sort.  Every pass counts the slice,
+// waits for all the counts, works out where its own keys go from them
+// (every thread does the same prefix sums, which is cheaper than another
+// wait), scatters, and waits for all the scatters.
+//
+void DepthSort::radixThread(int t) {
+	int begin = sliceBegin(t), end = sliceEnd(t);
+	if (bMakeKeys) makeKeys(t);
+
+	uint32_t * srcKeys = keys.data(), * dstKeys = tmpKeys.data();
+	int * srcIndices = order.data(), * dstIndices = tmpIndices.data();
+	bool bSwapped = false;
+
+	for (int shift = 0; shift < 32; shift += 8) {
+		uint32_t * count = &counts[t * 256];
+		memset(count, 0, 256 * sizeof(uint32_t));
+		for (int i = begin; i < end; i++) count[(srcKeys[i] >> shift) & 255]++;
+		barrier.wait();
+
+		// offset[d]:  keys with a smaller digit, then the same digit in
+		// earlier slices
+		//
+		uint32_t offset[256];
+		uint32_t total = 0;
+		bool bSkip = false;
+		for (int d = 0; d < 256; d++) {
+			uint32_t digit = 0;
+			for (int k = 0; k < numThreads; k++) {
+				if (k == t) offset[d] = total + digit;
+				digit += counts[k * 256 + d];
+			}
+			if (digit == uint32_t(numKeys)) bSkip = true;
+			total += digit;
+		}
+
+		if (!bSkip) {
+			for (int i = begin; i < end; i++) {
+				uint32_t p = offset[(srcKeys[i] >> shift) & 255]++;
+				dstKeys[p] = srcKeys[i];
+				dstIndices[p] = srcIndices[i];
+			}
+			std::swap(srcKeys, dstKeys);
+			std::swap(srcIndices, dstIndices);
+			bSwapped = !bSwapped;
+		}
+		barrier.wait();
+	}
+	if (t == 0) bResultInTmp = bSwapped;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  DepthSort
+//
+//  Description:
+//  Back to front order of a set of particles for blending.
+//  Each particle's view space depth is turned into a 32 bit
+//  key that sorts as an unsigned integer (float bits, sign
+//  flipped), and the keys with their indices are put in order
+//  by an LSD radix sort, four passes of 8 bits.  A pass where
+//  every key has the same digit is skipped.
+//
+//  With more than parallelThreshold particles the key pass
+//  and every radix pass are split over threads:  each thread
+//  counts the digits of its own slice, the counts are turned
+//  into per thread offsets, and each thread scatters its slice
+//  (in order, so the sort stays stable).
+//
+//  The buffers and the worker threads are kept between calls,
+//  so sorting a set no larger than the last one, on no more
+//  threads, neither allocates nor starts a thread.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+#include "Particle.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class DepthSort {
+public:
+	static const int parallelThreshold = 16384;
+
+	~DepthSort();
+
+	// order (into particles) furthest from the camera first; view is the
+	// camera's view matrix.  numThreads 0 = one per core.
+	//
+	const vector<int> & sort(const Particle * particles, int n, const glm::mat4 & view, int numThreads = 0);
+	const vector<int> & sort(const vector<Particle> & particles, const glm::mat4 & view, int numThreads = 0) {
+		return sort(particles.data(), particles.size(), view, numThreads);
+	}
+
+	// radix sort keys and their indices in place (ascending), for the
+	// benchmark and for callers with keys of their own
+	//
+	void sortKeys(vector<uint32_t> & keys, vector<int> & indices, int numThreads = 0);
+
+	static uint32_t depthKey(float depth);
+
+	vector<int> order;
+
+private:
+	class Barrier {
+	public:
+		void reset(int count) { this->count = count; waiting = 0; generation = 0; }
+		void wait();
+
+	private:
+		mutex lock;
+		condition_variable wake;
+		int count = 0;
+		int waiting = 0;
+		int generation = 0;
+	};
+
+	void run(int threads);
+	void workerThread(int t, int seen);
+	void radixThread(int t);
+	void makeKeys(int t);
+
+	// slice of thread t
+	//
+	int sliceBegin(int t) const { return int(int64_t(numKeys) * t / numThreads); }
+	int sliceEnd(int t) const { return int(int64_t(numKeys) * (t + 1) / numThreads); }
+
+	vector<uint32_t> keys, tmpKeys;   // keys go with order
+	vector<int> tmpIndices;
+	vector<uint32_t> counts;          // [thread][256]
+	int numKeys = 0;
+	int numThreads = 1;
+	bool bResultInTmp = false;
+
+	// key pass input, while sorting particles
+	//
+	const Particle * particles = NULL;
+	glm::mat4 view;
+	bool bMakeKeys = false;
+
+	Barrier barrier;
+
+	// worker pool:  workers[t - 1] sorts slice t, each time generation
+	// changes; busy counts the ones not done yet
+	//
+	vector<thread> workers;
+	mutex poolLock;
+	condition_variable poolWake, poolDone;
+	int generation = 0;
+	int busy = 0;
+	bool bQuit = false;
+};
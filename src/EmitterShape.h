@@ -0,0 +1,207 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  EmitterShape
+//
+//  Description:
+//  Spawn shapes for ShapeEmitter, one policy class per shape.
+//  Each samples a whole group of spawn positions and
+//  velocities at once into a SpawnBatch:  the random numbers
+//  are drawn first, then plain loops over float arrays turn
+//  them into positions and directions, which the compiler can
+//  vectorize.  No per particle branching on the shape.
+//
+//  Directional    every particle at the emitter, moving at velocity
+//  Radial         at the emitter, uniform random directions
+//  SphereSurface  on a sphere of radius, moving outward
+//  SphereVolume   inside a sphere of radius, moving outward
+//  Cone           at the emitter, within coneAngle of velocity
+//                 (thrusters)
+//  Disk           on a disk of radius in the xz plane, moving
+//                 outward in the plane (dust rings)
+//
+//  Speeds are the length of velocity.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+#include "ParticleSystem.h"
+
+class EmitterShape {
+public:
+	glm::vec3 position;
+	glm::vec3 velocity;
+	float radius = 1;
+	float coneAngle = 15;           // deg, half angle
+};
+
+// structure of arrays for one group of spawns, plus the random draws
+//
+class SpawnBatch {
+public:
+	vector<float> px, py, pz;
+	vector<float> vx, vy, vz;
+	vector<float> u, v, w;
+
+	void resize(int n) {
+		if (int(px.size()) >= n) return;
+		px.resize(n); py.resize(n); pz.resize(n);
+		vx.resize(n); vy.resize(n); vz.resize(n);
+		u.resize(n); v.resize(n); w.resize(n);
+	}
+};
+
+namespace EmitterShapes {
+
+	// unit directions, uniform over the sphere, from u, v in [0, 1)
+	//
+	inline void sphereDirections(int n, const float * u, const float * v, float * x, float * y, float * z) {
+		const float twoPi = 2 * PI;
+		for (int i = 0; i < n; i++) {
+			float cz = 2 * u[i] - 1;
+			float r = sqrt(max(0.0f, 1 - cz * cz));
+			float phi = twoPi * v[i];
+			x[i] = r * cos(phi);
+			y[i] = r * sin(phi);
+			z[i] = cz;
+		}
+	}
+
+	inline void fill(float * out, int n, float value) {
+		for (int i = 0; i < n; i++) out[i] = value;
+	}
+
+	// velocity = direction * speed, position = center + direction * dist
+	//
+	inline void outward(int n, const glm::vec3 & center, float speed, const float * dist,
+		SpawnBatch & b, const float * dx, const float * dy, const float * dz)
+	{
+		for (int i = 0; i < n; i++) {
+			b.px[i] = center.x + dx[i] * dist[i];
+			b.py[i] = center.y + dy[i] * dist[i];
+			b.pz[i] = center.z + dz[i] * dist[i];
+			b.vx[i] = dx[i] * speed;
+			b.vy[i] = dy[i] * speed;
+			b.vz[i] = dz[i] * speed;
+		}
+	}
+}
+
+class DirectionalShape {
+public:
+	static void sample(const EmitterShape & s, int n, SpawnBatch & b) {
+		b.resize(n);
+		EmitterShapes::fill(b.px.data(), n, s.position.x);
+		EmitterShapes::fill(b.py.data(), n, s.position.y);
+		EmitterShapes::fill(b.pz.data(), n, s.position.z);
+		EmitterShapes::fill(b.vx.data(), n, s.velocity.x);
+		EmitterShapes::fill(b.vy.data(), n, s.velocity.y);
+		EmitterShapes::fill(b.vz.data(), n, s.velocity.z);
+	}
+};
+
+class RadialShape {
+public:
+	static void sample(const EmitterShape & s, int n, SpawnBatch & b) {
+		b.resize(n);
+		threadRandomFill(b.u.data(), n, 0, 1);
+		threadRandomFill(b.v.data(), n, 0, 1);
+		EmitterShapes::fill(b.w.data(), n, 0);
+		EmitterShapes::sphereDirections(n, b.u.data(), b.v.data(), b.vx.data(), b.vy.data(), b.vz.data());
+		EmitterShapes::outward(n, s.position, glm::length(s.velocity), b.w.data(), b, b.vx.data(), b.vy.data(), b.vz.data());
+	}
+};
+
+class SphereSurfaceShape {
+public:
+	static void sample(const EmitterShape & s, int n, SpawnBatch & b) {
+		b.resize(n);
+		threadRandomFill(b.u.data(), n, 0, 1);
+		threadRandomFill(b.v.data(), n, 0, 1);
+		EmitterShapes::fill(b.w.data(), n, s.radius);
+		EmitterShapes::sphereDirections(n, b.u.data(), b.v.data(), b.vx.data(), b.vy.data(), b.vz.data());
+		EmitterShapes::outward(n, s.position, glm::length(s.velocity), b.w.data(), b, b.vx.data(), b.vy.data(), b.vz.data());
+	}
+};
+
+class SphereVolumeShape {
+public:
+	static void sample(const EmitterShape & s, int n, SpawnBatch & b) {
+		b.resize(n);
+		threadRandomFill(b.u.data(), n, 0, 1);
+		threadRandomFill(b.v.data(), n, 0, 1);
+		threadRandomFill(b.w.data(), n, 0, 1);
+
+		// cube root of a uniform draw keeps the density even through the volume
+		//
+		float * w = b.w.data();
+		for (int i = 0; i < n; i++) w[i] = s.radius * cbrt(w[i]);
+		EmitterShapes::sphereDirections(n, b.u.data(), b.v.data(), b.vx.data(), b.vy.data(), b.vz.data());
+		EmitterShapes::outward(n, s.position, glm::length(s.velocity), w, b, b.vx.data(), b.vy.data(), b.vz.data());
+	}
+};
+
+class ConeShape {
+public:
+	static void sample(const EmitterShape & s, int n, SpawnBatch & b) {
+		b.resize(n);
+		threadRandomFill(b.u.data(), n, 0, 1);
+		threadRandomFill(b.v.data(), n, 0, 1);
+
+		// basis around the cone axis, once per batch
+		//
+		float speed = glm::length(s.velocity);
+		glm::vec3 axis = speed > 0 ? s.velocity / speed : glm::vec3(0, -1, 0);
+		glm::vec3 t = fabs(axis.y) < 0.9 ? glm::normalize(glm::cross(axis, glm::vec3(0, 1, 0))) : glm::normalize(glm::cross(axis, glm::vec3(1, 0, 0)));
+		glm::vec3 bt = glm::cross(axis, t);
+
+		// directions uniform over the spherical cap within coneAngle
+		//
+		float cosMax = cos(ofDegToRad(s.coneAngle));
+		const float twoPi = 2 * PI;
+		const float * u = b.u.data();
+		const float * v = b.v.data();
+		for (int i = 0; i < n; i++) {
+			float ct = 1 - u[i] * (1 - cosMax);
+			float st = sqrt(max(0.0f, 1 - ct * ct));
+			float phi = twoPi * v[i];
+			float a = st * cos(phi);
+			float c = st * sin(phi);
+			b.vx[i] = (t.x * a + bt.x * c + axis.x * ct) * speed;
+			b.vy[i] = (t.y * a + bt.y * c + axis.y * ct) * speed;
+			b.vz[i] = (t.z * a + bt.z * c + axis.z * ct) * speed;
+		}
+		EmitterShapes::fill(b.px.data(), n, s.position.x);
+		EmitterShapes::fill(b.py.data(), n, s.position.y);
+		EmitterShapes::fill(b.pz.data(), n, s.position.z);
+	}
+};
+
+class DiskShape {
+public:
+	static void sample(const EmitterShape & s, int n, SpawnBatch & b) {
+		b.resize(n);
+		threadRandomFill(b.u.data(), n, 0, 1);
+		threadRandomFill(b.v.data(), n, 0, 1);
+
+		// sqrt of a uniform draw keeps the density even over the area
+		//
+		float speed = glm::length(s.velocity);
+		const float twoPi = 2 * PI;
+		const float * u = b.u.data();
+		const float * v = b.v.data();
+		for (int i = 0; i < n; i++) {
+			float r = s.radius * sqrt(u[i]);
+			float phi = twoPi * v[i];
+			float cx = cos(phi);
+			float cz = sin(phi);
+			b.px[i] = s.position.x + cx * r;
+			b.py[i] = s.position.y;
+			b.pz[i] = s.position.z + cz * r;
+			b.vx[i] = cx * speed;
+			b.vy[i] = 0;
+			b.vz[i] = cz * speed;
+		}
+	}
+};
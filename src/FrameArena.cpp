@@ -0,0 +1,120 @@
+//--------------------------------------------------------------
+//
+//  FrameArena
+//
+//--------------------------------------------------------------
+
+#include "FrameArena.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+FrameArena::~FrameArena() {
+	for (int i = 0; i < int(blocks.size()); i++) free(blocks[i].data);
+}
+
+FrameArena & FrameArena::local() {
+	static thread_local FrameArena arena;
+	return arena;
+}
+
+// allocate:  bump within the current block; past its end move on to the
+// next block big enough, chaining a new one if there is none
+//
+void * FrameArena::allocate(size_t bytes, size_t align) {
+	if (bytes == 0) bytes = 1;
+	if (current < int(blocks.size())) {
+		Block & b = blocks[current];
+		size_t start = (offset + align - 1) & ~(align - 1);
+		if (start + bytes <= b.size) {
+			offset = start + bytes;
+			highWater = max(highWater, used());
+			return b.data + start;
+		}
+		current++;
+	}
+	while (current < int(blocks.size()) && blocks[current].size < bytes) current++;
+	if (current == int(blocks.size())) {
+		Block b;
+		b.size = max(blockSize, bytes);
+		b.data = (char *) malloc(b.size);
+		if (b.data == NULL) throw bad_alloc();
+		blocks.push_back(b);
+	}
+
+	// malloc'ed blocks start aligned for any fundamental type
+	//
+	offset = bytes;
+	highWater = max(highWater, used());
+	return blocks[current].data;
+}
+
+void FrameArena::reset() {
+	current = 0;
+	offset = 0;
+}
+
+FrameArena::Mark FrameArena::mark() const {
+	Mark m;
+	m.block = current;
+	m.offset = offset;
+	return m;
+}
+
+void FrameArena::rewind(const Mark & m) {
+	current = m.block;
+	offset = m.offset;
+}
+
+size_t FrameArena::used() const {
+	size_t n = offset;
+	for (int i = 0; i < current && i < int(blocks.size()); i++) n += blocks[i].size;
+	return n;
+}
+
+size_t FrameArena::capacity() const {
+	size_t n = 0;
+	for (int i = 0; i < int(blocks.size()); i++) n += blocks[i].size;
+	return n;
+}
+
+//--------------------------------------------------------------
+//
+//  Allocation counter:  replaces the global operator new and
+//  delete with malloc / free plus one relaxed atomic add.
+//
+//--------------------------------------------------------------
+
+static atomic<uint64_t> allocations(0);
+
+uint64_t heapAllocations() {
+	return allocations.load(memory_order_relaxed);
+}
+
+#if LANDER_COUNT_ALLOCS
+
+static void * countedNew(size_t bytes) {
+	allocations.fetch_add(1, memory_order_relaxed);
+	void * p = malloc(bytes ? bytes : 1);
+	if (p == NULL) throw bad_alloc();
+	return p;
+}
+
+void * operator new(size_t bytes) { return countedNew(bytes); }
+void * operator new[](size_t bytes) { return countedNew(bytes); }
+void * operator new(size_t bytes, const nothrow_t &) noexcept {
+	allocations.fetch_add(1, memory_order_relaxed);
+	return malloc(bytes ? bytes : 1);
+}
+void * operator new[](size_t bytes, const nothrow_t &) noexcept {
+	allocations.fetch_add(1, memory_order_relaxed);
+	return malloc(bytes ? bytes : 1);
+}
+void operator delete(void * p) noexcept { free(p); }
+void operator delete[](void * p) noexcept { free(p); }
+void operator delete(void * p, size_t) noexcept { free(p); }
+void operator delete[](void * p, size_t) noexcept { free(p); }
+void operator delete(void * p, const nothrow_t &) noexcept { free(p); }
+void operator delete[](void * p, const nothrow_t &) noexcept { free(p); }
+
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  FrameArena
+//
+//  Description:
+//  Bump allocator for scratch memory that only lives for one
+//  frame (or one simulation step, or one job).  Each thread
+//  has its own arena (FrameArena::local()), so allocating
+//  takes no lock.  Allocating moves a pointer forward and
+//  freeing does nothing; reset() at the start of the frame
+//  gives everything back at once.  When a block runs out the
+//  arena chains another one from the heap, and keeps it, so
+//  once the arena has seen the largest frame it stops going
+//  to the heap altogether.
+//
+//  FrameVector / FrameString are the standard containers on
+//  the calling thread's arena.  Nothing allocated from an
+//  arena may outlive the next reset() on that thread; for
+//  scratch inside a job, FrameArenaScope rewinds to where the
+//  job started instead.
+//
+//  heapAllocations() counts operator new calls on all threads,
+//  for the per frame allocation counter.  Build with
+//  LANDER_COUNT_ALLOCS=0 to leave operator new alone.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+
+#ifndef LANDER_COUNT_ALLOCS
+#define LANDER_COUNT_ALLOCS 1
+#endif
+
+class FrameArena {
+public:
+	static const size_t defaultBlockSize = 256 * 1024;
+
+	FrameArena(size_t blockSize = defaultBlockSize) : blockSize(blockSize) {}
+	~FrameArena();
+
+	// this thread's arena
+	//
+	static FrameArena & local();
+
+	void * allocate(size_t bytes, size_t align);
+	void reset();
+
+	// where the arena is now, and back to it (frees everything since)
+	//
+	class Mark {
+	public:
+		int block;
+		size_t offset;
+	};
+	Mark mark() const;
+	void rewind(const Mark & m);
+
+	size_t used() const;                // bytes handed out since reset()
+	size_t capacity() const;            // bytes in all blocks
+	size_t highWater = 0;               // most used between resets
+
+private:
+	FrameArena(const FrameArena &);
+	FrameArena & operator=(const FrameArena &);
+
+	class Block {
+	public:
+		char * data;
+		size_t size;
+	};
+	vector<Block> blocks;
+	int current = 0;                    // block allocating from
+	size_t offset = 0;                  // into blocks[current]
+	size_t blockSize;
+};
+
+// rewinds the thread's arena when it goes out of scope
+//
+class FrameArenaScope {
+public:
+	FrameArenaScope(FrameArena & arena = FrameArena::local()) : arena(arena), start(arena.mark()) {}
+	~FrameArenaScope() { arena.rewind(start); }
+
+private:
+	FrameArena & arena;
+	FrameArena::Mark start;
+};
+
+// standard allocator on an arena, by default the constructing thread's
+//
+template<class T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+
+	ArenaAllocator() : arena(&FrameArena::local()) {}
+	ArenaAllocator(FrameArena & arena) : arena(&arena) {}
+	template<class U> ArenaAllocator(const ArenaAllocator<U> & other) : arena(other.arena) {}
+
+	T * allocate(size_t n) { return (T *) arena->allocate(n * sizeof(T), alignof(T)); }
+	void deallocate(T *, size_t) {}
+
+	template<class U> bool operator==(const ArenaAllocator<U> & other) const { return arena == other.arena; }
+	template<class U> bool operator!=(const ArenaAllocator<U> & other) const { return arena != other.arena; }
+
+	FrameArena * arena;
+};
+
+template<class T> using FrameVector = vector<T, ArenaAllocator<T> >;
+typedef basic_string<char, char_traits<char>, ArenaAllocator<char> > FrameString;
+
+// operator new calls so far, all threads (0 with LANDER_COUNT_ALLOCS=0)
+//
+uint64_t heapAllocations();
@@ -0,0 +1,261 @@
+//--------------------------------------------------------------
+//
+//  Heightfield
+//
+//--------------------------------------------------------------
+
+#include "Heightfield.h"
+#include <fstream>
+#include <thread>
+#include <sys/stat.h>
+
+static const char heightMagic[4] = { 'L', 'H', 'G', 'T' };
+static const uint32_t heightVersion = 1;
+
+static bool sourceStamp(const string & path, uint64_t & size, uint64_t & time) {
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0) return false;
+	size = st.st_size;
+	time = st.st_mtime;
+	return true;
+}
+
+// corners of triangle t; meshes without indices are read as consecutive
+// triangles, as BVH::build() does
+//
+static void triangle(const ofMesh & mesh, int t, glm::vec3 & a, glm::vec3 & b, glm::vec3 & c) {
+	if (mesh.getNumIndices() > 0) {
+		a = mesh.getVertex(mesh.getIndex(t * 3));
+		b = mesh.getVertex(mesh.getIndex(t * 3 + 1));
+		c = mesh.getVertex(mesh.getIndex(t * 3 + 2));
+	}
+	else {
+		a = mesh.getVertex(t * 3);
+		b = mesh.getVertex(t * 3 + 1);
+		c = mesh.getVertex(t * 3 + 2);
+	}
+}
+
+static int numTriangles(const ofMesh & mesh) {
+	return (mesh.getNumIndices() > 0 ? mesh.getNumIndices() : mesh.getNumVertices()) / 3;
+}
+
+void Heightfield::clear() {
+	width = depth = 0;
+	heights.clear();
+	cellMin.clear();
+	cellMax.clear();
+}
+
+// build:  size the grid to the mesh bounds, then rasterize the triangles
+// into bands of rows, one band per thread.  Each band only writes its own
+// rows, so the threads share nothing but the (read only) mesh.
+//
+void Heightfield::build(const ofMesh & mesh, int resolution, int numThreads) {
+	uint64_t t1 = ofGetElapsedTimeMicros();
+	clear();
+	if (mesh.getNumVertices() < 3 || resolution < 1) return;
+
+	glm::vec3 min = mesh.getVertex(0), max = mesh.getVertex(0);
+	for (int i = 1; i < int(mesh.getNumVertices()); i++) {
+		min = glm::min(min, mesh.getVertex(i));
+		max = glm::max(max, mesh.getVertex(i));
+	}
+	cellSize = std::max(max.x - min.x, max.z - min.z) / resolution;
+	if (cellSize <= 0) cellSize = 1;
+	originX = min.x;
+	originZ = min.z;
+	width = int(ceil((max.x - min.x) / cellSize)) + 1;
+	depth = int(ceil((max.z - min.z) / cellSize)) + 1;
+	heights.assign(size_t(width) * depth, min.y);
+	cellMin.assign(size_t(width - 1) * (depth - 1), FLT_MAX);
+	cellMax.assign(size_t(width - 1) * (depth - 1), -FLT_MAX);
+
+	if (numThreads < 1) numThreads = std::max(1, int(thread::hardware_concurrency()));
+	numThreads = std::min(numThreads, depth);
+	vector<thread> threads;
+	int rows = (depth + numThreads - 1) / numThreads;
+	for (int t = 1; t < numThreads; t++) {
+		threads.push_back(thread(&Heightfield::buildRows, this, std::cref(mesh), t * rows, std::min(depth, (t + 1) * rows)));
+	}
+	buildRows(mesh, 0, std::min(depth, rows));
+	for (int t = 0; t < int(threads.size()); t++) threads[t].join();
+
+	uint64_t t2 = ofGetElapsedTimeMicros();
+	buildTime = (t2 - t1) / 1000.0;
+}
+
+// buildRows:  samples of rows [row0, row1) take the highest triangle over
+// them; cells of those rows take the bounds of every triangle whose
+// bounds reach into them
+//
+void Heightfield::buildRows(const ofMesh & mesh, int row0, int row1) {
+	int cellRow1 = std::min(row1, depth - 1);
+	int n = numTriangles(mesh);
+	glm::vec3 a, b, c;
+	for (int t = 0; t < n; t++) {
+		triangle(mesh, t, a, b, c);
+		glm::vec3 lo = glm::min(a, glm::min(b, c));
+		glm::vec3 hi = glm::max(a, glm::max(b, c));
+
+		int j0 = std::max(row0, int(floor((lo.z - originZ) / cellSize)));
+		int j1 = std::min(row1 - 1, int(floor((hi.z - originZ) / cellSize)));
+		if (j0 > j1) continue;
+		int i0 = std::max(0, int(floor((lo.x - originX) / cellSize)));
+		int i1 = std::min(width - 1, int(floor((hi.x - originX) / cellSize)));
+
+		// cells
+		//
+		for (int j = j0; j <= std::min(j1, cellRow1 - 1); j++) {
+			for (int i = i0; i <= std::min(i1, width - 2); i++) {
+				size_t cell = size_t(j) * (width - 1) + i;
+				cellMin[cell] = std::min(cellMin[cell], lo.y);
+				cellMax[cell] = std::max(cellMax[cell], hi.y);
+			}
+		}
+
+		// samples inside the triangle (seen from above), by barycentric
+		// coordinates in x, z; skip triangles standing on edge
+		//
+		float det = (b.z - c.z) * (a.x - c.x) + (c.x - b.x) * (a.z - c.z);
+		if (fabs(det) < 1e-12) continue;
+		int sj0 = std::max(row0, int(ceil((lo.z - originZ) / cellSize)));
+		int sj1 = std::min(row1 - 1, int(floor((hi.z - originZ) / cellSize)));
+		int si0 = std::max(0, int(ceil((lo.x - originX) / cellSize)));
+		int si1 = std::min(width - 1, int(floor((hi.x - originX) / cellSize)));
+		for (int j = sj0; j <= sj1; j++) {
+			float z = originZ + j * cellSize;
+			for (int i = si0; i <= si1; i++) {
+				float x = originX + i * cellSize;
+				float u = ((b.z - c.z) * (x - c.x) + (c.x - b.x) * (z - c.z)) / det;
+				float v = ((c.z - a.z) * (x - c.x) + (a.x - c.x) * (z - c.z)) / det;
+				float w = 1 - u - v;
+				if (u < -1e-6 || v < -1e-6 || w < -1e-6) continue;
+				float y = u * a.y + v * b.y + w * c.y;
+				float & h = heights[size_t(j) * width + i];
+				h = std::max(h, y);
+			}
+		}
+	}
+}
+
+bool Heightfield::contains(float x, float z) const {
+	if (empty()) return false;
+	float fx = (x - originX) / cellSize;
+	float fz = (z - originZ) / cellSize;
+	return fx >= 0 && fz >= 0 && fx <= width - 1 && fz <= depth - 1;
+}
+
+float Heightfield::height(float x, float z) const {
+	if (empty()) return 0;
+	if (width < 2 || depth < 2) return heights[0];
+	float fx = ofClamp((x - originX) / cellSize, 0, width - 1);
+	float fz = ofClamp((z - originZ) / cellSize, 0, depth - 1);
+	int i = std::min(int(fx), width - 2);
+	int j = std::min(int(fz), depth - 2);
+	float s = fx - i;
+	float t = fz - j;
+	float h0 = sample(i, j) + (sample(i + 1, j) - sample(i, j)) * s;
+	float h1 = sample(i, j + 1) + (sample(i + 1, j + 1) - sample(i, j + 1)) * s;
+	return h0 + (h1 - h0) * t;
+}
+
+bool Heightfield::groundBelow(const glm::vec3 & p, glm::vec3 & pointRtn) const {
+	if (!contains(p.x, p.z)) return false;
+	float h = height(p.x, p.z);
+	if (p.y < h) return false;
+	pointRtn = glm::vec3(p.x, h, p.z);
+	return true;
+}
+
+// scan:  highest cellMax under box, or the first one at or above limit
+//
+float Heightfield::scan(const Box & box, float limit) const {
+	float top = -FLT_MAX;
+	if (width < 2 || depth < 2) return top;
+	Vector3 min = box.min();
+	Vector3 max = box.max();
+	int i0 = std::max(0, int(floor((min.x() - originX) / cellSize)));
+	int i1 = std::min(width - 2, int(floor((max.x() - originX) / cellSize)));
+	int j0 = std::max(0, int(floor((min.z() - originZ) / cellSize)));
+	int j1 = std::min(depth - 2, int(floor((max.z() - originZ) / cellSize)));
+	for (int j = j0; j <= j1; j++) {
+		const float * row = &cellMax[size_t(j) * (width - 1)];
+		for (int i = i0; i <= i1; i++) top = std::max(top, row[i]);
+		if (top >= limit) break;
+	}
+	return top;
+}
+
+//--------------------------------------------------------------
+//
+//  Cache file:  header, then heights, cellMin and cellMax as
+//  raw floats.  Written to a temporary file and renamed, so a
+//  reader never sees a half written one.
+//
+//--------------------------------------------------------------
+
+bool Heightfield::load(const string & source) {
+	clear();
+	ifstream in(ofToDataPath(cachePath(source), true).c_str(), ios::binary);
+	HeightfieldHeader header;
+	if (!in.read((char *) &header, sizeof(header))) return false;
+	if (memcmp(header.magic, heightMagic, 4) != 0 || header.version != heightVersion) return false;
+	if (header.width < 2 || header.depth < 2) return false;
+
+	uint64_t size, time;
+	if (sourceStamp(ofToDataPath(source, true), size, time) &&
+		(header.sourceSize != size || header.sourceTime != time)) return false;
+
+	width = header.width;
+	depth = header.depth;
+	originX = header.originX;
+	originZ = header.originZ;
+	cellSize = header.cellSize;
+	heights.resize(size_t(width) * depth);
+	cellMin.resize(size_t(width - 1) * (depth - 1));
+	cellMax.resize(cellMin.size());
+	in.read((char *) heights.data(), heights.size() * sizeof(float));
+	in.read((char *) cellMin.data(), cellMin.size() * sizeof(float));
+	in.read((char *) cellMax.data(), cellMax.size() * sizeof(float));
+	if (!in) {
+		clear();
+		return false;
+	}
+	buildTime = 0;
+	return true;
+}
+
+bool Heightfield::save(const string & source) const {
+	if (empty()) return false;
+	HeightfieldHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, heightMagic, 4);
+	header.version = heightVersion;
+	header.width = width;
+	header.depth = depth;
+	header.originX = originX;
+	header.originZ = originZ;
+	header.cellSize = cellSize;
+	sourceStamp(ofToDataPath(source, true), header.sourceSize, header.sourceTime);
+
+	string path = ofToDataPath(cachePath(source), true);
+	string tmpPath = path + ".tmp";
+	{
+		ofstream out(tmpPath.c_str(), ios::binary);
+		if (!out.is_open()) {
+			ofLogError("Heightfield") << "can't write " << tmpPath;
+			return false;
+		}
+		out.write((const char *) &header, sizeof(header));
+		out.write((const char *) heights.data(), heights.size() * sizeof(float));
+		out.write((const char *) cellMin.data(), cellMin.size() * sizeof(float));
+		out.write((const char *) cellMax.data(), cellMax.size() * sizeof(float));
+	}
+	remove(path.c_str());
+	if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+		ofLogError("Heightfield") << "can't write " << path;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  Heightfield
+//
+//  Description:
+//  The terrain mesh baked into a regular grid over x and z:  at
+//  each sample the height of the highest triangle above it,
+//  and for each cell between samples the lowest and highest
+//  point of any triangle reaching into it.  Height and
+//  altitude are a bilinear lookup, a vertical ray cast is one
+//  lookup, and "is this box clear of the ground" is a scan of
+//  the few cells under it, cheap enough to run before every
+//  octree query.
+//
+//  The cell bounds come from whole triangle bounds, so they
+//  are conservative:  a box above every cellMax under it can't
+//  touch the terrain.  Samples no triangle covers take the
+//  lowest point of the mesh.
+//
+//  build() rasterizes bands of rows on several threads.  The
+//  grid can be cached on disk next to the mesh it came from
+//  (see cachePath()); the cache is stale once the mesh file's
+//  size or modification time change.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+#include "box.h"
+
+class HeightfieldHeader {
+public:
+	char magic[4];
+	uint32_t version;
+	uint32_t width;
+	uint32_t depth;
+	float originX;
+	float originZ;
+	float cellSize;
+	uint32_t pad;
+	uint64_t sourceSize;        // source file size and modification
+	uint64_t sourceTime;        // time, a mismatch means stale
+};
+
+class Heightfield {
+public:
+	// sample mesh with about resolution cells along its longer side,
+	// numThreads bands of rows at once (0 = one per core)
+	//
+	void build(const ofMesh & mesh, int resolution, int numThreads = 0);
+	void clear();
+
+	// cache file of the mesh at source (a data path):  load() is false if
+	// there is none or it is stale
+	//
+	static string cachePath(const string & source) { return source + ".height"; }
+	bool load(const string & source);
+	bool save(const string & source) const;
+
+	bool empty() const { return heights.empty(); }
+	bool contains(float x, float z) const;
+
+	// ground height under x, z (bilinear, clamped at the edges), and
+	// the height of p above it
+	//
+	float height(float x, float z) const;
+	float altitude(const glm::vec3 & p) const { return p.y - height(p.x, p.z); }
+
+	// vertical ray cast:  the ground point straight below p, false if p
+	// is off the grid or under the ground
+	//
+	bool groundBelow(const glm::vec3 & p, glm::vec3 & pointRtn) const;
+
+	// highest terrain point in the cells under the xz extent of box
+	// (-FLT_MAX if none), and whether box is above all of it (stops at
+	// the first cell that reaches it)
+	//
+	float maxHeight(const Box & box) const { return scan(box, FLT_MAX); }
+	bool above(const Box & box) const { return scan(box, box.min().y()) < box.min().y(); }
+
+	int width = 0;                  // samples along x
+	int depth = 0;                  // samples along z
+	float originX = 0;              // x, z of sample 0
+	float originZ = 0;
+	float cellSize = 1;
+	vector<float> heights;          // width * depth, z rows
+	vector<float> cellMin;          // (width - 1) * (depth - 1), z rows
+	vector<float> cellMax;
+
+	float buildTime = 0;            // ms
+
+private:
+	void buildRows(const ofMesh & mesh, int row0, int row1);
+	float scan(const Box & box, float limit) const;
+	float sample(int i, int j) const { return heights[size_t(j) * width + i]; }
+};
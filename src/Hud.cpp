@@ -0,0 +1,103 @@
+//--------------------------------------------------------------
+//
+//  Hud
+//
+//--------------------------------------------------------------
+
+#include "Hud.h"
+
+int Hud::addStatic(const string & text, float ax, float dx, float ay, float dy) {
+	HudLine line;
+	line.text = text;
+	line.ax = ax;
+	line.dx = dx;
+	line.ay = ay;
+	line.dy = dy;
+	line.bValid = true;
+	staticLines.push_back(line);
+	bStaticDirty = true;
+	return staticLines.size() - 1;
+}
+
+int Hud::addField(float ax, float dx, float ay, float dy) {
+	HudLine line;
+	line.ax = ax;
+	line.dx = dx;
+	line.ay = ay;
+	line.dy = dy;
+	fields.push_back(line);
+	bDynamicDirty = true;
+	return fields.size() - 1;
+}
+
+bool Hud::changed(int field, int key) {
+	HudLine & line = fields[field];
+	if (line.bValid && line.key == key) return false;
+	line.key = key;
+	line.bValid = true;
+	return true;
+}
+
+void Hud::setText(int field, const string & text) {
+	fields[field].text = text;
+	textsPending++;
+	bDynamicDirty = true;
+}
+
+void Hud::drawLines(const vector<HudLine> & lines) {
+	for (int i = 0; i < int(lines.size()); i++) {
+		const HudLine & line = lines[i];
+		if (line.text.empty()) continue;
+		ofDrawBitmapString(line.text, line.ax * width + line.dx, line.ay * height + line.dy);
+		stats.linesRasterized++;
+	}
+}
+
+void Hud::rasterize(ofFbo & fbo, const vector<HudLine> & lines) {
+	if (!fbo.isAllocated() || fbo.getWidth() != width || fbo.getHeight() != height) {
+		fbo.allocate(width, height, GL_RGBA);
+	}
+	fbo.begin();
+	ofClear(0, 0, 0, 0);
+	ofSetColor(ofColor::white);
+	drawLines(lines);
+	fbo.end();
+}
+
+// draw:  rasterize what changed, then draw both layers.  Counters are
+// for this frame only.
+//
+void Hud::draw() {
+	stats.linesRasterized = 0;
+	stats.textsBuilt = textsPending;
+	stats.drawCalls = 0;
+	textsPending = 0;
+
+	if (width != ofGetWindowWidth() || height != ofGetWindowHeight()) {
+		width = ofGetWindowWidth();
+		height = ofGetWindowHeight();
+		bStaticDirty = bDynamicDirty = true;
+	}
+
+	ofSetColor(ofColor::white);
+	if (!bCache) {
+		drawLines(staticLines);
+		drawLines(fields);
+		stats.drawCalls = stats.linesRasterized;
+		return;
+	}
+	if (width < 1 || height < 1) return;
+
+	if (bStaticDirty) {
+		rasterize(staticFbo, staticLines);
+		bStaticDirty = false;
+	}
+	if (bDynamicDirty) {
+		rasterize(dynamicFbo, fields);
+		bDynamicDirty = false;
+	}
+	ofEnableAlphaBlending();
+	staticFbo.draw(0, 0);
+	dynamicFbo.draw(0, 0);
+	stats.drawCalls = 2;
+}
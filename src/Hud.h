@@ -0,0 +1,76 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  Hud
+//
+//  Description:
+//  On screen text in two layers, each rendered into an FBO that
+//  is drawn as one textured quad per frame.  The static layer
+//  (tips, control help) is rasterized once and again only when
+//  the window is resized.  The dynamic layer holds fields -
+//  velocity, fuel, altitude, game state - each keyed by the
+//  value it shows:  the caller asks changed(field, key) and
+//  only builds the field's text when it did, and the layer is
+//  rasterized again only in frames where some field changed.
+//
+//  Line positions are fractions of the window plus pixel
+//  offsets, so a resize only needs a rasterize.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+
+class HudLine {
+public:
+	string text;
+	float ax = 0, ay = 0;       // position:  (ax * width + dx, ay * height + dy)
+	float dx = 0, dy = 0;
+	int key = 0;                // value the text shows (fields only)
+	bool bValid = false;        // key and text set at least once
+};
+
+// work done in the last draw(), for the profiler
+//
+class HudStats {
+public:
+	int linesRasterized = 0;    // lines drawn into the FBOs
+	int textsBuilt = 0;         // field texts set since the draw before
+	int drawCalls = 0;          // FBOs (or, uncached, lines) drawn to the screen
+};
+
+class Hud {
+public:
+	// add a line that never changes, or a field; both return the line's
+	// index
+	//
+	int addStatic(const string & text, float ax, float dx, float ay, float dy);
+	int addField(float ax, float dx, float ay, float dy);
+
+	// true (and key remembered) if field now shows a different key; the
+	// caller then sets its text
+	//
+	bool changed(int field, int key);
+	void setText(int field, const string & text);
+
+	void draw();
+
+	// bCache off draws every line straight to the screen each frame, as
+	// the app used to, for comparison in the profiler
+	//
+	bool bCache = true;
+	HudStats stats;
+
+	vector<HudLine> staticLines;
+	vector<HudLine> fields;
+
+private:
+	void rasterize(ofFbo & fbo, const vector<HudLine> & lines);
+	void drawLines(const vector<HudLine> & lines);
+
+	ofFbo staticFbo, dynamicFbo;
+	int width = 0, height = 0;
+	bool bStaticDirty = true;
+	bool bDynamicDirty = true;
+	int textsPending = 0;       // set since the last draw()
+};
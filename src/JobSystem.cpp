@@ -0,0 +1,117 @@
+//--------------------------------------------------------------
+//
+//  JobSystem
+//
+//--------------------------------------------------------------
+
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "FrameArena.h"
+
+JobSystem::~JobSystem() {
+	{
+		lock_guard<mutex> guard(lock);
+		bQuit = true;
+	}
+	wake.notify_all();
+	for (int i = 0; i < int(workers.size()); i++) workers[i].join();
+}
+
+void JobSystem::start(int numThreads) {
+	if (numThreads < 1) numThreads = max(1, int(thread::hardware_concurrency()) - 1);
+	for (int i = 0; i < numThreads; i++) {
+		workers.push_back(thread(&JobSystem::workerThread, this));
+	}
+}
+
+int JobSystem::add(const char * name, function<void()> work, initializer_list<int> after) {
+	if (numJobs == int(jobs.size())) jobs.push_back(Job());
+	int id = numJobs++;
+	Job & job = jobs[id];
+	job.name = name;
+	job.zone = Profiler::instance().zoneId(name);
+	job.work = move(work);
+	job.next.clear();
+	job.pending = 0;
+	for (int a : after) depends(id, a);
+	return id;
+}
+
+// depends:  job starts only once after is done (after < 0 is ignored, so
+// optional jobs can be passed straight through)
+//
+void JobSystem::depends(int job, int after) {
+	if (after < 0) return;
+	jobs[after].next.push_back(job);
+	jobs[job].pending++;
+}
+
+void JobSystem::run() {
+	{
+		lock_guard<mutex> guard(lock);
+		remaining = numJobs;
+		for (int i = 0; i < numJobs; i++) {
+			if (jobs[i].pending == 0) ready.push_back(i);
+		}
+	}
+	wake.notify_all();
+
+	// the calling thread works too, until the last job is done
+	//
+	while (true) {
+		int id;
+		{
+			unique_lock<mutex> guard(lock);
+			wake.wait(guard, [this] { return remaining == 0 || readyHead < int(ready.size()); });
+			if (remaining == 0) {
+				// reset under the lock the workers read ready and readyHead
+				// under; keep the slots, drop what the jobs captured
+				//
+				for (int i = 0; i < numJobs; i++) jobs[i].work = nullptr;
+				numJobs = 0;
+				ready.clear();
+				readyHead = 0;
+				break;
+			}
+			id = ready[readyHead++];
+		}
+		execute(id);
+	}
+}
+
+void JobSystem::workerThread() {
+	while (true) {
+		int id;
+		{
+			unique_lock<mutex> guard(lock);
+			wake.wait(guard, [this] { return bQuit || readyHead < int(ready.size()); });
+			if (bQuit) return;
+			id = ready[readyHead++];
+		}
+		execute(id);
+	}
+}
+
+// execute:  run one job, then release the jobs that were waiting on it
+//
+void JobSystem::execute(int id) {
+	{
+		ProfileZone zone(jobs[id].zone);
+		FrameArenaScope scratch;
+		jobs[id].work();
+	}
+
+	bool bWake = false;
+	{
+		lock_guard<mutex> guard(lock);
+		Job & job = jobs[id];
+		for (int i = 0; i < int(job.next.size()); i++) {
+			if (--jobs[job.next[i]].pending == 0) {
+				ready.push_back(job.next[i]);
+				bWake = true;
+			}
+		}
+		if (--remaining == 0) bWake = true;
+	}
+	if (bWake) wake.notify_all();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  JobSystem
+//
+//  Description:
+//  Per-frame task graph on a small worker pool.  Jobs are
+//  added with the jobs they must wait for; run() starts every
+//  job whose dependencies are done, helps the workers from the
+//  calling thread and returns when the whole graph has run.
+//  The graph is cleared after each run, so it is rebuilt every
+//  frame.  Cleared jobs keep their slots (and the capacity of
+//  their vectors) for the next frame, so once the graph has
+//  been built once adding jobs doesn't allocate.  Each job runs
+//  in a FrameArenaScope:  scratch it takes from the running
+//  thread's frame arena is given back when it returns.
+//
+//  Each job is a profiler zone under its own name, so the
+//  trace (Profiler::dumpTrace) shows which thread ran what and
+//  the frame's critical path.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+#include <condition_variable>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <thread>
+
+class Job {
+public:
+	const char * name;
+	int zone;
+	function<void()> work;
+	vector<int> next;               // jobs waiting for this one
+	int pending = 0;                // dependencies not done yet
+};
+
+class JobSystem {
+public:
+	~JobSystem();
+
+	// start the workers (numThreads 0 = one less than the cores)
+	//
+	void start(int numThreads = 0);
+
+	// returns the job id to pass in after for later jobs.  name must
+	// outlive the job system (a string literal).
+	//
+	int add(const char * name, function<void()> work, initializer_list<int> after = {});
+	void depends(int job, int after);
+
+	// run the graph to completion, then clear it
+	//
+	void run();
+
+	int numThreads() const { return workers.size() + 1; }
+
+private:
+	void workerThread();
+	void execute(int id);
+
+	vector<Job> jobs;               // jobs[0 .. numJobs), the rest are spare slots
+	int numJobs = 0;
+	vector<int> ready;              // ready[readyHead ..) wait for a thread
+	int readyHead = 0;
+	int remaining = 0;
+	vector<thread> workers;
+	mutex lock;
+	condition_variable wake;
+	bool bQuit = false;
+};
@@ -0,0 +1,42 @@
+#include "Lander.h"
+
+LanderBody::LanderBody() {
+	position = glm::vec3(0, 0, 0);
+	velocity = glm::vec3(0, 0, 0);
+	forces = glm::vec3(0, 0, 0);
+	rotation = 0;
+	angularVelocity = 0;
+	torque = 0;
+	mass = 1;
+	damping = .99;
+}
+
+void LanderBody::reset(const glm::vec3 & position, float rotation) {
+	this->position = position;
+	this->rotation = rotation;
+}
+
+// semi-implicit Euler with damping, as Particle::integrate()
+//
+void LanderBody::integrate(float dt) {
+	position += velocity * dt;
+	velocity += forces * (1.0f / mass) * dt;
+	velocity *= damping;
+
+	rotation += angularVelocity * dt;
+	angularVelocity += torque * (1.0f / mass) * dt;
+	angularVelocity *= damping;
+
+	forces = glm::vec3(0, 0, 0);
+	torque = 0;
+}
+
+glm::vec3 LanderBody::heading() const {
+	glm::vec3 rotate(cos(rotation), 0, sin(rotation));
+	return glm::normalize(rotate);
+}
+
+glm::mat4 LanderBody::modelToWorld(const glm::vec3 & position, float rotation) {
+	glm::mat4 m = glm::translate(glm::mat4(1.0), position);
+	return glm::rotate(m, glm::radians(rotation), glm::vec3(0, 1, 0));
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  LanderBody
+//
+//  Description:
+//  Rigid body state of the lander:  position, velocity and a
+//  rotation about y.  Forces and torques added during a step
+//  are integrated and cleared by integrate(), the same way a
+//  Particle's are, but there is exactly one body and nothing
+//  spawns or expires.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+
+class LanderBody {
+public:
+	LanderBody();
+
+	void reset(const glm::vec3 & position, float rotation = 0);
+
+	// force inputs, cleared by integrate()
+	//
+	void addForce(const glm::vec3 & f) { forces += f; }
+	void addTorque(float t) { torque += t; }
+
+	void integrate(float dt);
+
+	// stop all motion (landed, crashed)
+	//
+	void stop() {
+		velocity = glm::vec3(0, 0, 0);
+		angularVelocity = 0;
+	}
+
+	// direction the lander faces in the xz plane
+	//
+	glm::vec3 heading() const;
+
+	// lander model space (the model's raw sub-mesh vertices, which its
+	// scene bounds measure) to the world:  rotation about y, then the
+	// position.  The hulls, the broad phase box (OBB::fromBox) and the
+	// B key's sub-mesh boxes all go through this.
+	//
+	static glm::mat4 modelToWorld(const glm::vec3 & position, float rotation);
+	glm::mat4 modelToWorld() const { return modelToWorld(position, rotation); }
+
+	glm::vec3 position;
+	glm::vec3 velocity;
+	glm::vec3 forces;
+	float rotation;             // deg about y
+	float angularVelocity;
+	float torque;
+	float mass;
+	float damping;
+};
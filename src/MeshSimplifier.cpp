@@ -0,0 +1,205 @@
+//--------------------------------------------------------------
+//
+//  MeshSimplifier
+//
+//--------------------------------------------------------------
+
+#include "MeshSimplifier.h"
+
+// quadric of the plane ax + by + cz + d = 0 (unit normal) - the
+// squared distance of a point to the plane
+//
+Quadric::Quadric(double a, double b, double c, double d) {
+	q[0] = a * a; q[1] = a * b; q[2] = a * c; q[3] = a * d;
+	q[4] = b * b; q[5] = b * c; q[6] = b * d;
+	q[7] = c * c; q[8] = c * d;
+	q[9] = d * d;
+	numPlanes = 1;
+}
+
+double Quadric::error(const glm::vec3 & p) const {
+	double x = p.x, y = p.y, z = p.z;
+	return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x +
+		q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y +
+		q[7] * z * z + 2 * q[8] * z + q[9];
+}
+
+MeshSimplifier::MeshSimplifier(const vector<glm::vec3> & positions, const vector<int> & indices, const vector<bool> & locked)
+	: positions(positions), indices(indices), locked(locked)
+{
+	int n = positions.size();
+	int numTris = indices.size() / 3;
+	deadVertex.assign(n, false);
+	deadTriangle.assign(numTris, false);
+	stamp.assign(n, 0);
+	quadrics.resize(n);
+	vertexTriangles.resize(n);
+	liveTriangles = numTris;
+
+	for (int t = 0; t < numTris; t++) {
+		const glm::vec3 & p0 = positions[indices[t * 3]];
+		const glm::vec3 & p1 = positions[indices[t * 3 + 1]];
+		const glm::vec3 & p2 = positions[indices[t * 3 + 2]];
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float len = glm::length(normal);
+		if (len > 0) {
+			normal /= len;
+			Quadric plane = Quadric(normal.x, normal.y, normal.z, -glm::dot(normal, p0));
+			for (int k = 0; k < 3; k++) quadrics[indices[t * 3 + k]].add(plane);
+		}
+		for (int k = 0; k < 3; k++) vertexTriangles[indices[t * 3 + k]].push_back(t);
+	}
+
+	vector<pair<int, int> > edges;
+	for (int t = 0; t < numTris; t++) {
+		for (int k = 0; k < 3; k++) {
+			int a = indices[t * 3 + k];
+			int b = indices[t * 3 + (k + 1) % 3];
+			edges.push_back(pair<int, int>(min(a, b), max(a, b)));
+		}
+	}
+	sort(edges.begin(), edges.end());
+	edges.erase(unique(edges.begin(), edges.end()), edges.end());
+	for (int i = 0; i < int(edges.size()); i++) pushEdge(edges[i].first, edges[i].second);
+}
+
+// pushEdge:  queue the cheaper allowed direction of collapsing the edge
+//
+void MeshSimplifier::pushEdge(int a, int b) {
+	if (locked[a] && locked[b]) return;
+	Quadric q = quadrics[a];
+	q.add(quadrics[b]);
+
+	Collapse c;
+	c.cost = DBL_MAX;
+	if (!locked[a]) {
+		c.cost = q.error(positions[b]);
+		c.from = a;
+		c.to = b;
+	}
+	if (!locked[b]) {
+		double cost = q.error(positions[a]);
+		if (cost < c.cost) {
+			c.cost = cost;
+			c.from = b;
+			c.to = a;
+		}
+	}
+	c.meanError = q.numPlanes > 0 ? c.cost / q.numPlanes : 0;
+	c.fromStamp = stamp[c.from];
+	c.toStamp = stamp[c.to];
+	heap.push(c);
+}
+
+// canCollapse:  moving from onto to must not fold a triangle over or
+// pinch the surface (the two vertices may only share the neighbors of
+// the triangles on the edge - the link condition)
+//
+bool MeshSimplifier::canCollapse(int from, int to) {
+	int sharedTris = 0;
+	vector<int> fromNeighbors, toNeighbors;
+	for (int i = 0; i < int(vertexTriangles[from].size()); i++) {
+		int t = vertexTriangles[from][i];
+		if (deadTriangle[t]) continue;
+		int * tri = &indices[t * 3];
+		bool hasTo = tri[0] == to || tri[1] == to || tri[2] == to;
+		if (hasTo) sharedTris++;
+		for (int k = 0; k < 3; k++) {
+			if (tri[k] != from) fromNeighbors.push_back(tri[k]);
+		}
+		if (hasTo) continue;
+
+		glm::vec3 p[3], q[3];
+		for (int k = 0; k < 3; k++) {
+			p[k] = positions[tri[k]];
+			q[k] = tri[k] == from ? positions[to] : p[k];
+		}
+		glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+		glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+		float lenAfter = glm::length(after);
+		if (lenAfter < 1e-12) return false;
+		if (glm::dot(before, after) < 0.2 * glm::length(before) * lenAfter) return false;
+	}
+	for (int i = 0; i < int(vertexTriangles[to].size()); i++) {
+		int t = vertexTriangles[to][i];
+		if (deadTriangle[t]) continue;
+		for (int k = 0; k < 3; k++) {
+			if (indices[t * 3 + k] != to) toNeighbors.push_back(indices[t * 3 + k]);
+		}
+	}
+	sort(fromNeighbors.begin(), fromNeighbors.end());
+	fromNeighbors.erase(unique(fromNeighbors.begin(), fromNeighbors.end()), fromNeighbors.end());
+	sort(toNeighbors.begin(), toNeighbors.end());
+	toNeighbors.erase(unique(toNeighbors.begin(), toNeighbors.end()), toNeighbors.end());
+
+	// from and to are neighbors of each other, not counted as shared
+	//
+	int common = 0;
+	for (int i = 0, j = 0; i < int(fromNeighbors.size()) && j < int(toNeighbors.size());) {
+		if (fromNeighbors[i] < toNeighbors[j]) i++;
+		else if (fromNeighbors[i] > toNeighbors[j]) j++;
+		else {
+			common++;
+			i++;
+			j++;
+		}
+	}
+	return sharedTris > 0 && common <= sharedTris;
+}
+
+void MeshSimplifier::collapse(int from, int to) {
+	for (int i = 0; i < int(vertexTriangles[from].size()); i++) {
+		int t = vertexTriangles[from][i];
+		if (deadTriangle[t]) continue;
+		int * tri = &indices[t * 3];
+		if (tri[0] == to || tri[1] == to || tri[2] == to) {
+			deadTriangle[t] = true;
+			liveTriangles--;
+			continue;
+		}
+		for (int k = 0; k < 3; k++) {
+			if (tri[k] == from) tri[k] = to;
+		}
+		vertexTriangles[to].push_back(t);
+	}
+	vertexTriangles[from].clear();
+	deadVertex[from] = true;
+	quadrics[to].add(quadrics[from]);
+	stamp[to]++;
+
+	// drop the dead triangles and requeue the edges around to
+	//
+	vector<int> & tris = vertexTriangles[to];
+	int n = 0;
+	for (int i = 0; i < int(tris.size()); i++) {
+		if (!deadTriangle[tris[i]]) tris[n++] = tris[i];
+	}
+	tris.resize(n);
+	for (int i = 0; i < int(tris.size()); i++) {
+		for (int k = 0; k < 3; k++) {
+			int w = indices[tris[i] * 3 + k];
+			if (w != to) pushEdge(to, w);
+		}
+	}
+}
+
+int MeshSimplifier::simplify(int targetTriangles) {
+	while (liveTriangles > targetTriangles && !heap.empty()) {
+		Collapse c = heap.top();
+		heap.pop();
+		if (deadVertex[c.from] || deadVertex[c.to]) continue;
+		if (c.fromStamp != stamp[c.from] || c.toStamp != stamp[c.to]) continue;
+		if (!canCollapse(c.from, c.to)) continue;
+		collapse(c.from, c.to);
+		maxError = max(maxError, c.meanError);
+	}
+	return liveTriangles;
+}
+
+void MeshSimplifier::getIndices(vector<int> & indicesRtn) const {
+	indicesRtn.clear();
+	for (int t = 0; t < int(deadTriangle.size()); t++) {
+		if (deadTriangle[t]) continue;
+		for (int k = 0; k < 3; k++) indicesRtn.push_back(indices[t * 3 + k]);
+	}
+}
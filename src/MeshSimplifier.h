@@ -0,0 +1,81 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  MeshSimplifier
+//
+//  Description:
+//  Quadric error edge collapse (Garland / Heckbert).  Edges are
+//  collapsed cheapest first onto one of their end points (half
+//  edge collapse), so the simplified mesh indexes a subset of
+//  the original vertices and keeps their normals and texture
+//  coordinates.  Locked vertices never move; locking the open
+//  edges of a chunk keeps its border identical at every level,
+//  so neighboring chunks at different levels still meet.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+#include <queue>
+
+// symmetric 4x4 error quadric (upper triangle) - the sum of the squared
+// distances to a set of planes, numPlanes of them
+//
+class Quadric {
+public:
+	Quadric() { for (int i = 0; i < 10; i++) q[i] = 0; }
+	Quadric(double a, double b, double c, double d);
+
+	void add(const Quadric & o) {
+		for (int i = 0; i < 10; i++) q[i] += o.q[i];
+		numPlanes += o.numPlanes;
+	}
+	double error(const glm::vec3 & p) const;
+
+	double q[10];
+	double numPlanes = 0;
+};
+
+class MeshSimplifier {
+public:
+	MeshSimplifier(const vector<glm::vec3> & positions, const vector<int> & indices, const vector<bool> & locked);
+
+	// collapse edges until at most targetTriangles are left or no edge
+	// can go without folding the surface over; may be called again with
+	// a lower target to continue.  Returns the triangles left.
+	//
+	int simplify(int targetTriangles);
+	void getIndices(vector<int> & indicesRtn) const;
+	int numTriangles() const { return liveTriangles; }
+
+	// largest mean squared distance of a collapsed vertex to the planes
+	// of the triangles it was merged from - roughly the squared distance
+	// the surface moved so far
+	//
+	double maxError = 0;
+
+private:
+	class Collapse {
+	public:
+		double cost;
+		double meanError;       // cost per plane
+		int from, to;
+		int fromStamp, toStamp;
+		bool operator>(const Collapse & c) const { return cost > c.cost; }
+	};
+
+	void pushEdge(int a, int b);
+	bool canCollapse(int from, int to);
+	void collapse(int from, int to);
+
+	const vector<glm::vec3> & positions;
+	vector<int> indices;
+	vector<bool> locked;
+	vector<bool> deadVertex;
+	vector<bool> deadTriangle;
+	vector<int> stamp;
+	vector<Quadric> quadrics;
+	vector<vector<int> > vertexTriangles;
+	priority_queue<Collapse, vector<Collapse>, greater<Collapse> > heap;
+	int liveTriangles = 0;
+};
@@ -0,0 +1,319 @@
+//--------------------------------------------------------------
+//
+//  Narrowphase
+//
+//--------------------------------------------------------------
+
+#include "Narrowphase.h"
+
+// point of the Minkowski difference a - b, with the points of a and b
+// it came from (for the contact point)
+//
+class SupportPoint {
+public:
+	glm::vec3 p, a, b;
+};
+
+static const glm::vec3 & furthest(const glm::vec3 * points, int n, const glm::vec3 & d) {
+	int best = 0;
+	float bestDot = glm::dot(points[0], d);
+	for (int i = 1; i < n; i++) {
+		float dot = glm::dot(points[i], d);
+		if (dot > bestDot) {
+			bestDot = dot;
+			best = i;
+		}
+	}
+	return points[best];
+}
+
+static SupportPoint support(const glm::vec3 * a, int na, const glm::vec3 * b, int nb, const glm::vec3 & d) {
+	SupportPoint s;
+	s.a = furthest(a, na, d);
+	s.b = furthest(b, nb, -d);
+	s.p = s.a - s.b;
+	return s;
+}
+
+static bool towards(const glm::vec3 & d, const glm::vec3 & ao) {
+	return glm::dot(d, ao) > 0;
+}
+
+//--------------------------------------------------------------
+//
+//  GJK
+//
+//  The simplex keeps its newest point first.  Each case drops
+//  the points that don't face the origin and returns the next
+//  search direction; the tetrahedron case returns true once
+//  it encloses the origin.
+//
+//--------------------------------------------------------------
+
+class Simplex {
+public:
+	SupportPoint s[4];
+	int n = 0;
+
+	void push(const SupportPoint & p) {
+		for (int i = min(n, 3); i > 0; i--) s[i] = s[i - 1];
+		s[0] = p;
+		n = min(n + 1, 4);
+	}
+	void set(const SupportPoint & a) { s[0] = a; n = 1; }
+	void set(const SupportPoint & a, const SupportPoint & b) { s[0] = a; s[1] = b; n = 2; }
+	void set(const SupportPoint & a, const SupportPoint & b, const SupportPoint & c) { s[0] = a; s[1] = b; s[2] = c; n = 3; }
+};
+
+static bool line(Simplex & simplex, glm::vec3 & d) {
+	SupportPoint a = simplex.s[0];
+	SupportPoint b = simplex.s[1];
+	glm::vec3 ab = b.p - a.p;
+	glm::vec3 ao = -a.p;
+	if (towards(ab, ao)) d = glm::cross(glm::cross(ab, ao), ab);
+	else {
+		simplex.set(a);
+		d = ao;
+	}
+	return false;
+}
+
+static bool triangle(Simplex & simplex, glm::vec3 & d) {
+	SupportPoint a = simplex.s[0];
+	SupportPoint b = simplex.s[1];
+	SupportPoint c = simplex.s[2];
+	glm::vec3 ab = b.p - a.p;
+	glm::vec3 ac = c.p - a.p;
+	glm::vec3 ao = -a.p;
+	glm::vec3 abc = glm::cross(ab, ac);
+
+	if (towards(glm::cross(abc, ac), ao)) {
+		if (towards(ac, ao)) {
+			simplex.set(a, c);
+			d = glm::cross(glm::cross(ac, ao), ac);
+			return false;
+		}
+		simplex.set(a, b);
+		return line(simplex, d);
+	}
+	if (towards(glm::cross(ab, abc), ao)) {
+		simplex.set(a, b);
+		return line(simplex, d);
+	}
+	if (towards(abc, ao)) d = abc;
+	else {
+		simplex.set(a, c, b);
+		d = -abc;
+	}
+	return false;
+}
+
+static bool tetrahedron(Simplex & simplex, glm::vec3 & d) {
+	SupportPoint a = simplex.s[0];
+	SupportPoint b = simplex.s[1];
+	SupportPoint c = simplex.s[2];
+	SupportPoint e = simplex.s[3];
+	glm::vec3 ab = b.p - a.p;
+	glm::vec3 ac = c.p - a.p;
+	glm::vec3 ae = e.p - a.p;
+	glm::vec3 ao = -a.p;
+
+	if (towards(glm::cross(ab, ac), ao)) {
+		simplex.set(a, b, c);
+		return triangle(simplex, d);
+	}
+	if (towards(glm::cross(ac, ae), ao)) {
+		simplex.set(a, c, e);
+		return triangle(simplex, d);
+	}
+	if (towards(glm::cross(ae, ab), ao)) {
+		simplex.set(a, e, b);
+		return triangle(simplex, d);
+	}
+	return true;
+}
+
+static bool nextSimplex(Simplex & simplex, glm::vec3 & d) {
+	switch (simplex.n) {
+	case 2: return line(simplex, d);
+	case 3: return triangle(simplex, d);
+	case 4: return tetrahedron(simplex, d);
+	}
+	return false;
+}
+
+//--------------------------------------------------------------
+//
+//  EPA
+//
+//  Grows the GJK tetrahedron into a polytope that hugs the
+//  Minkowski difference near the origin.  Faces are kept wound
+//  counter-clockwise from outside; a new support point removes
+//  the faces it can see and is fanned to their horizon, until
+//  the nearest face is (within tolerance) on the surface.
+//
+//--------------------------------------------------------------
+
+class EPAFace {
+public:
+	int v[3];
+	glm::vec3 normal;
+	float dist;
+};
+
+static bool makeFace(const SupportPoint * verts, int a, int b, int c, EPAFace & f) {
+	glm::vec3 n = glm::cross(verts[b].p - verts[a].p, verts[c].p - verts[a].p);
+	float len = glm::length(n);
+	if (len < 1e-12) return false;
+	f.v[0] = a;
+	f.v[1] = b;
+	f.v[2] = c;
+	f.normal = n / len;
+	f.dist = glm::dot(f.normal, verts[a].p);
+
+	// the origin is inside, so an outward face is at positive distance
+	//
+	if (f.dist < 0) {
+		swap(f.v[1], f.v[2]);
+		f.normal = -f.normal;
+		f.dist = -f.dist;
+	}
+	return true;
+}
+
+// barycentric coordinates of p (in the plane of a, b, c)
+//
+static glm::vec3 barycentric(const glm::vec3 & p, const glm::vec3 & a, const glm::vec3 & b, const glm::vec3 & c) {
+	glm::vec3 v0 = b - a, v1 = c - a, v2 = p - a;
+	float d00 = glm::dot(v0, v0);
+	float d01 = glm::dot(v0, v1);
+	float d11 = glm::dot(v1, v1);
+	float d20 = glm::dot(v2, v0);
+	float d21 = glm::dot(v2, v1);
+	float denom = d00 * d11 - d01 * d01;
+	if (fabs(denom) < 1e-12) return glm::vec3(1, 0, 0);
+	float v = (d11 * d20 - d01 * d21) / denom;
+	float w = (d00 * d21 - d01 * d20) / denom;
+	return glm::vec3(1 - v - w, v, w);
+}
+
+static void touching(const Simplex & simplex, Contact & contact) {
+	contact.point = simplex.s[0].b;
+	contact.normal = glm::vec3(0, 1, 0);
+	contact.depth = 0;
+}
+
+// The polytope lives in fixed arrays on the stack (no allocation per
+// call).  A closed polytope of V vertices has 2V - 4 faces and a horizon
+// of at most V edges.
+//
+static const int maxEPAIterations = 32;
+static const int maxEPAVerts = 4 + maxEPAIterations;
+static const int maxEPAFaces = 2 * maxEPAVerts;
+
+static void epa(const Simplex & simplex, const glm::vec3 * a, int na, const glm::vec3 * b, int nb, Contact & contact) {
+	const float tolerance = 1e-4;
+
+	SupportPoint verts[maxEPAVerts];
+	EPAFace faces[maxEPAFaces];
+	pair<int, int> edges[maxEPAVerts * 2];
+	int numVerts = 4;
+	int numFaces = 0;
+	for (int i = 0; i < 4; i++) verts[i] = simplex.s[i];
+	int tet[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 0, 2, 3 }, { 1, 3, 2 } };
+	for (int i = 0; i < 4; i++) {
+		if (makeFace(verts, tet[i][0], tet[i][1], tet[i][2], faces[numFaces])) numFaces++;
+	}
+
+	// a flat simplex (the origin on a face of the difference): touching
+	//
+	if (numFaces < 4) {
+		touching(simplex, contact);
+		return;
+	}
+
+	for (int iteration = 0; iteration < maxEPAIterations; iteration++) {
+		int nearest = 0;
+		for (int i = 1; i < numFaces; i++) {
+			if (faces[i].dist < faces[nearest].dist) nearest = i;
+		}
+		glm::vec3 n = faces[nearest].normal;
+		SupportPoint s = support(a, na, b, nb, n);
+		if (glm::dot(n, s.p) - faces[nearest].dist < tolerance) break;
+
+		// remove the faces s can see, keeping the edges only one of them
+		// had (the horizon)
+		//
+		int numEdges = 0;
+		bool full = false;
+		for (int i = 0; i < numFaces; ) {
+			if (glm::dot(faces[i].normal, s.p - verts[faces[i].v[0]].p) > 0) {
+				for (int k = 0; k < 3; k++) {
+					int from = faces[i].v[k];
+					int to = faces[i].v[(k + 1) % 3];
+					int twin = 0;
+					while (twin < numEdges && !(edges[twin].first == to && edges[twin].second == from)) twin++;
+					if (twin < numEdges) edges[twin] = edges[--numEdges];
+					else if (numEdges < maxEPAVerts * 2) edges[numEdges++] = make_pair(from, to);
+					else full = true;
+				}
+				faces[i] = faces[--numFaces];
+			}
+			else i++;
+		}
+		if (full || numFaces + numEdges > maxEPAFaces) break;
+
+		int added = 0;
+		verts[numVerts] = s;
+		for (int i = 0; i < numEdges; i++) {
+			if (makeFace(verts, edges[i].first, edges[i].second, numVerts, faces[numFaces])) {
+				numFaces++;
+				added++;
+			}
+		}
+		numVerts++;
+		if (added == 0 || numVerts == maxEPAVerts) break;
+	}
+	if (numFaces == 0) {
+		touching(simplex, contact);
+		return;
+	}
+
+	int nearest = 0;
+	for (int i = 1; i < numFaces; i++) {
+		if (faces[i].dist < faces[nearest].dist) nearest = i;
+	}
+
+	// the origin projected onto the nearest face, in terms of the points
+	// of b that made it up
+	//
+	const EPAFace & f = faces[nearest];
+	glm::vec3 bary = barycentric(f.normal * f.dist, verts[f.v[0]].p, verts[f.v[1]].p, verts[f.v[2]].p);
+	contact.point = verts[f.v[0]].b * bary.x + verts[f.v[1]].b * bary.y + verts[f.v[2]].b * bary.z;
+	contact.normal = -f.normal;
+	contact.depth = f.dist;
+}
+
+bool convexOverlap(const glm::vec3 * a, int na, const glm::vec3 * b, int nb, Contact * contact) {
+	const int maxIterations = 64;
+	if (na < 1 || nb < 1) return false;
+
+	glm::vec3 d = a[0] - b[0];
+	if (glm::dot(d, d) < 1e-12) d = glm::vec3(1, 0, 0);
+
+	Simplex simplex;
+	simplex.push(support(a, na, b, nb, d));
+	d = -simplex.s[0].p;
+
+	for (int iteration = 0; iteration < maxIterations; iteration++) {
+		if (glm::dot(d, d) < 1e-12) return false;
+		SupportPoint s = support(a, na, b, nb, d);
+		if (glm::dot(s.p, d) <= 0) return false;
+		simplex.push(s);
+		if (nextSimplex(simplex, d)) {
+			if (contact) epa(simplex, a, na, b, nb, *contact);
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  Narrowphase
+//
+//  Description:
+//  Exact contact between two convex shapes, each given as a
+//  set of points (their convex hull):  GJK decides whether the
+//  hulls overlap, then EPA walks out the Minkowski difference
+//  to the nearest face for the penetration depth, normal and
+//  contact point.  Used between the lander's sub-mesh hulls
+//  and the terrain triangles the broad phase (octree or BVH)
+//  hands back.
+//
+//  Both only ever ask a shape for its support point, so the
+//  cost is a handful of iterations over the few vertices of a
+//  hull and a triangle:  microseconds per pair.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+
+class Contact {
+public:
+	glm::vec3 point;                // on the surface of b
+	glm::vec3 normal;               // unit, out of b toward a
+	float depth = 0;                // how far to move a along normal to separate
+};
+
+// GJK:  true if the convex hulls of a (na points) and b (nb points)
+// overlap; touching without overlap counts as apart.  With contact,
+// EPA then fills in where and how deep.
+//
+bool convexOverlap(const glm::vec3 * a, int na, const glm::vec3 * b, int nb, Contact * contact = NULL);
@@ -11,6 +11,7 @@
 
 
 #include "Octree.h"
+#include <queue>
  
 
 
@@ -57,7 +58,7 @@ Box Octree::meshBounds(const ofMesh & mesh) {
 //                      inside the Box.  Return count of points found;
 //
 int Octree::getMeshPointsInBox(const ofMesh & mesh, const vector<int>& points,
-	Box & box, vector<int> & pointsRtn)
+	const Box & box, vector<int> & pointsRtn) const
 {
 	int count = 0;
 	for (int i = 0; i < points.size(); i++) {
@@ -70,11 +71,27 @@ int Octree::getMeshPointsInBox(const ofMesh & mesh, const vector<int>& points,
 	return count;
 }
 
+// getPointsInBox:  same as getMeshPointsInBox() but against the tree's own
+//                  vertex positions.  Return count of points found;
+//
+int Octree::getPointsInBox(const vector<int>& points, const Box & box, vector<int> & pointsRtn) const
+{
+	int count = 0;
+	for (int i = 0; i < points.size(); i++) {
+		const glm::vec3 & v = vertices[points[i]];
+		if (box.inside(Vector3(v.x, v.y, v.z))) {
+			count++;
+			pointsRtn.push_back(points[i]);
+		}
+	}
+	return count;
+}
+
 // getMeshFacesInBox:  return an array of indices to Faces in mesh that are contained 
 //                      inside the Box.  Return count of faces found;
 //
 int Octree::getMeshFacesInBox(const ofMesh & mesh, const vector<int>& faces,
-	Box & box, vector<int> & facesRtn)
+	const Box & box, vector<int> & facesRtn) const
 {
 	int count = 0;
 	for (int i = 0; i < faces.size(); i++) {
@@ -98,44 +115,102 @@ int Octree::getMeshFacesInBox(const ofMesh & mesh, const vector<int>& faces,
 //  Subdivide a Box into eight(8) equal size boxes, return them in boxList;
 //
 void Octree::subDivideBox8(const Box &box, vector<Box> & boxList) {
+	Box b[8];
+	subDivideBox8(box, b);
+	boxList.assign(b, b + 8);
+}
+
+//  Same, into a fixed array - the tree's own subdivisions use this one so
+//  splitting a node doesn't go to the heap for the boxes.  The corners
+//  are taken from the parent's min, center and max as they are (not
+//  built up by adding half sizes), so the eight boxes tile the parent
+//  exactly and rounding can't leave a point on a far face outside all
+//  of them.
+//
+void Octree::subDivideBox8(const Box &box, Box b[8]) {
 	Vector3 min = box.parameters[0];
 	Vector3 max = box.parameters[1];
-	Vector3 size = max - min;
-	Vector3 center = size / 2 + min;
-	float xdist = (max.x() - min.x()) / 2;
-	float ydist = (max.y() - min.y()) / 2;
-	float zdist = (max.z() - min.z()) / 2;
-	Vector3 h = Vector3(0, ydist, 0);
+	Vector3 center = box.center();
+	float x[3] = { min.x(), center.x(), max.x() };
+	float y[3] = { min.y(), center.y(), max.y() };
+	float z[3] = { min.z(), center.z(), max.z() };
 
-	//  generate ground floor
+	//  ground floor (min, +x, +x +z, +z), then the second story above it
 	//
-	Box b[8];
-	b[0] = Box(min, center);
-	b[1] = Box(b[0].min() + Vector3(xdist, 0, 0), b[0].max() + Vector3(xdist, 0, 0));
-	b[2] = Box(b[1].min() + Vector3(0, 0, zdist), b[1].max() + Vector3(0, 0, zdist));
-	b[3] = Box(b[2].min() + Vector3(-xdist, 0, 0), b[2].max() + Vector3(-xdist, 0, 0));
+	int ox[4] = { 0, 1, 1, 0 };
+	int oz[4] = { 0, 0, 1, 1 };
+	for (int i = 0; i < 8; i++) {
+		int ix = ox[i & 3], iy = i >> 2, iz = oz[i & 3];
+		b[i] = Box(Vector3(x[ix], y[iy], z[iz]), Vector3(x[ix + 1], y[iy + 1], z[iz + 1]));
+	}
+}
 
-	boxList.clear();
-	for (int i = 0; i < 4; i++) {
-		boxList.push_back(b[i]);
+// create:  build the tree from a mesh.  Only the vertex positions and
+// the triangles are copied (no normals, texcoords or colors).
+//
+void Octree::create(const ofMesh & geo, int numLevels) {
+	positions = geo.getVertices();
+	indexFaces(geo);
+	create(positions.data(), positions.size(), numLevels);
+}
+
+// indexFaces:  copy the mesh's triangles and list the triangles around
+// each vertex.  Meshes without indices are read as consecutive
+// triangles, as BVH::build() does.
+//
+void Octree::indexFaces(const ofMesh & mesh) {
+	faces.clear();
+	if (mesh.getNumIndices() > 0) {
+		int n = mesh.getNumIndices() / 3 * 3;
+		for (int i = 0; i < n; i++) faces.push_back(mesh.getIndex(i));
+	}
+	else {
+		for (int i = 0; i + 2 < int(mesh.getNumVertices()); i += 3) {
+			faces.push_back(i);
+			faces.push_back(i + 1);
+			faces.push_back(i + 2);
+		}
 	}
 
-	// generate second story
-	//
-	for (int i = 4; i < 8; i++) {
-		b[i] = Box(b[i - 4].min() + h, b[i - 4].max() + h);
-		boxList.push_back(b[i]);
+	int n = mesh.getNumVertices();
+	faceStart.assign(n + 1, 0);
+	for (int i = 0; i < int(faces.size()); i++) faceStart[faces[i] + 1]++;
+	for (int i = 0; i < n; i++) faceStart[i + 1] += faceStart[i];
+	vertexFaces.resize(faces.size());
+	vector<int> fill(faceStart.begin(), faceStart.end() - 1);
+	for (int i = 0; i < int(faces.size()); i++) vertexFaces[fill[faces[i]]++] = i / 3;
+
+	maxEdge = 0;
+	const vector<glm::vec3> & v = mesh.getVertices();
+	for (int i = 0; i < int(faces.size()); i += 3) {
+		for (int k = 0; k < 3; k++) {
+			maxEdge = std::max(maxEdge, glm::length(v[faces[i + k]] - v[faces[i + (k + 1) % 3]]));
+		}
 	}
 }
 
-void Octree::create(const ofMesh & geo, int numLevels) {
+// create:  build the tree over an external, read-only vertex buffer.  The
+// buffer is referenced, not copied, and must outlive the tree; it is
+// only copied if the tree is later modified with insert() or move().
+//
+void Octree::create(const glm::vec3 * verts, int n, int numLevels) {
 	// initialize octree structure
 	//
-	mesh = geo;
+	if (verts != positions.data()) {
+		positions.clear();
+		faces.clear();
+		faceStart.clear();
+		vertexFaces.clear();
+		maxEdge = 0;
+	}
+	vertices = verts;
+	numVertices = n;
+	maxLevels = numLevels;
 	int level = 0;
-	root.box = meshBounds(mesh);
+	root = TreeNode();
+	root.box = pointBounds(vertices, numVertices);
 	if (!bUseFaces) {
-		for (int i = 0; i < mesh.getNumVertices(); i++) {
+		for (int i = 0; i < numVertices; i++) {
 			root.points.push_back(i);
 		}
 	}
@@ -146,8 +221,46 @@ void Octree::create(const ofMesh & geo, int numLevels) {
 
 	// recursively buid octree
 	//
+	uint64_t t1 = ofGetElapsedTimeMicros();
 	level++;
-    subdivide(mesh, root, numLevels, level);
+	subdivide(root, numLevels, level);
+	uint64_t t2 = ofGetElapsedTimeMicros();
+
+	report = OctreeBuildReport();
+	report.buildTime = (t2 - t1) / 1000.0;
+	buildReport(root, level);
+	if (report.numLeaves > 0) report.avgLeafPoints /= report.numLeaves;
+	numLeaf = report.numLeaves;
+}
+
+// buildReport:  walk the tree and gather depth and leaf occupancy
+//
+void Octree::buildReport(const TreeNode & node, int level) {
+	report.numNodes++;
+	if (level > report.depth) report.depth = level;
+	if (node.children.size() < 1) {
+		int n = node.points.size();
+		report.numLeaves++;
+		report.avgLeafPoints += n;
+		if (n > report.maxLeafPoints) report.maxLeafPoints = n;
+		return;
+	}
+	for (int i = 0; i < node.children.size(); i++) {
+		buildReport(node.children[i], level + 1);
+	}
+}
+
+// return a Bounding Box for an array of points
+//
+Box Octree::pointBounds(const glm::vec3 * points, int n) {
+	if (n < 1) return Box(Vector3(0, 0, 0), Vector3(0, 0, 0));
+	glm::vec3 min = points[0];
+	glm::vec3 max = points[0];
+	for (int i = 1; i < n; i++) {
+		min = glm::min(min, points[i]);
+		max = glm::max(max, points[i]);
+	}
+	return Box(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z));
 }
 
 
@@ -165,37 +278,393 @@ void Octree::create(const ofMesh & geo, int numLevels) {
 //         
 //      
              
-void Octree::subdivide(const ofMesh& mesh, TreeNode& node, int numLevels, int level) {
-	if (level >= numLevels) return;
+void Octree::subdivide(TreeNode& node, int numLevels, int level) {
+	Vector3 size = node.box.max() - node.box.min();
+	if (level >= numLevels || int(node.points.size()) <= maxLeafPoints ||
+		(size.x() < minExtent && size.y() < minExtent && size.z() < minExtent)) {
+		if (bLean) node.points.shrink_to_fit();
+		return;
+	}
 
-	vector <Box> myVec;
-	vector <int> tempVec;
+	Box myVec[8];
+	vector <int> tempVec[8];
 	TreeNode child;
 
 	// subdvide algorithm implemented here
 	subDivideBox8(node.box, myVec);
-	for (int i = 0; i < myVec.size(); i++) {
-		if (getMeshPointsInBox(mesh, node.points, myVec.at(i), tempVec) > 0) {
-			child.points = tempVec;
-			child.box = myVec.at(i);
+	for (int i = 0; i < 8; i++) {
+		getPointsInBox(node.points, myVec[i], tempVec[i]);
+	}
+	if (bUseSAH && !splitWorthIt(node, myVec, tempVec)) {
+		if (bLean) node.points.shrink_to_fit();
+		return;
+	}
+
+	// reserve up front - growing the vector would copy the subtrees
+	// already built under the earlier children
+	//
+	int numChildren = 0;
+	for (int i = 0; i < 8; i++) {
+		if (tempVec[i].size() > 0) numChildren++;
+	}
+	node.children.reserve(node.children.size() + numChildren);
+
+	for (int i = 0; i < 8; i++) {
+		if (tempVec[i].size() > 0) {
+			child.box = myVec[i];
 			node.children.push_back(child);
-			subdivide(mesh, node.children.back(), numLevels, level+1);
+			node.children.back().points.swap(tempVec[i]);
+			subdivide(node.children.back(), numLevels, level+1);
+		}
+	}
+
+	// in lean mode an interior node only needs its list long enough
+	// to sort the points into its children
+	//
+	if (bLean && node.children.size() > 0) {
+		vector<int>().swap(node.points);
+		node.children.shrink_to_fit();
+	}
+}
+
+// splitWorthIt:  surface area heuristic - compare the expected cost of
+// testing the points of node directly against descending into the
+// children (the chance of a query reaching a child is taken as the ratio
+// of its surface area to the parent's)
+//
+static float surfaceArea(const Box & box) {
+	Vector3 d = box.parameters[1] - box.parameters[0];
+	return 2 * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+}
+
+bool Octree::splitWorthIt(const TreeNode & node, const Box * boxList, const vector<int> * childPoints) {
+	float area = surfaceArea(node.box);
+	if (area <= 0) return true;
+
+	float leafCost = intersectCost * node.points.size();
+	float splitCost = traversalCost;
+	for (int i = 0; i < 8; i++) {
+		if (childPoints[i].size() > 0)
+			splitCost += surfaceArea(boxList[i]) / area * intersectCost * childPoints[i].size();
+	}
+	return splitCost < leafCost;
+}
+
+//
+// Incremental updates
+//
+//  Only the nodes whose boxes contain the old or the new position are
+//  touched.  As in create(), a point lying on a shared face is stored
+//  in every child box that contains it.  The updates run on a lean tree
+//  (the first one drops the interior point lists):  an interior list
+//  holds every point below it, the root's all of them, so keeping them
+//  would make every update a linear search.  The updates descend by box
+//  instead, and only search the few points of a leaf.
+//
+//  Node boxes are fixed octants of their parent, not the bounds of what
+//  they hold, so nothing has to be refit on the way back up.
+//
+
+// insert:  add a new vertex to the tree, return its index
+//
+int Octree::insert(const ofVec3f & point) {
+	makeWritable();
+	positions.push_back(point);
+	vertices = positions.data();
+	numVertices = positions.size();
+	int i = numVertices - 1;
+	insert(i);
+	return i;
+}
+
+// insert:  add an existing vertex (not yet in the tree) to the tree
+//
+bool Octree::insert(int point) {
+	if (point < 0 || point >= numVertices) return false;
+	makeLean();
+	const glm::vec3 & v = vertices[point];
+	Vector3 p = Vector3(v.x, v.y, v.z);
+
+	// grow the tree upward until the root contains the point
+	//
+	while (!root.box.inside(p)) growRoot(p);
+
+	insert(root, point, p, 1);
+	return true;
+}
+
+void Octree::insert(TreeNode & node, int point, const Vector3 & p, int level) {
+
+	// leaf - split it if it is now over the occupancy threshold
+	//
+	if (node.children.size() < 1) {
+		node.points.push_back(point);
+		subdivide(node, maxLevels, level);
+		return;
+	}
+	Box boxList[8];
+	subDivideBox8(node.box, boxList);
+	for (int i = 0; i < 8; i++) {
+		if (boxList[i].inside(p)) {
+			insert(childFor(node, boxList[i]), point, p, level + 1);
 		}
 	}
 }
 
+// remove:  take a vertex out of the tree (the vertex itself is kept
+// so other indices stay valid).  Empty children are pruned and subtrees
+// that fall to mergeThreshold points are collapsed into a leaf.
+//
+bool Octree::remove(int point) {
+	if (point < 0 || point >= numVertices) return false;
+	makeLean();
+	const glm::vec3 & v = vertices[point];
+	return remove(root, point, Vector3(v.x, v.y, v.z));
+}
+
+bool Octree::remove(TreeNode & node, int point, const Vector3 & p) {
+	if (!node.box.inside(p)) return false;
+
+	bool found = false;
+	if (node.children.size() < 1) {
+		vector<int>::iterator it = find(node.points.begin(), node.points.end(), point);
+		if (it == node.points.end()) return false;
+		*it = node.points.back();
+		node.points.pop_back();
+		found = true;
+	}
+
+	for (int i = 0; i < int(node.children.size()); ) {
+		if (remove(node.children[i], point, p)) found = true;
+		if (isEmpty(node.children[i])) {
+			node.children.erase(node.children.begin() + i);
+		}
+		else i++;
+	}
+
+	if (found) merge(node);
+	return found;
+}
+
+// move:  change the position of a vertex already in the tree.  Only the
+// subtrees where the old and new paths diverge are updated; ancestors
+// that contain both positions are left alone.
+//
+bool Octree::move(int point, const ofVec3f & newPos) {
+	if (point < 0 || point >= numVertices) return false;
+	makeWritable();
+	makeLean();
+	const glm::vec3 & v = vertices[point];
+	Vector3 oldPos = Vector3(v.x, v.y, v.z);
+	Vector3 p = Vector3(newPos.x, newPos.y, newPos.z);
+
+	if (!root.box.inside(p)) {
+		remove(point);
+		positions[point] = newPos;
+		stretchEdges(point);
+		return insert(point);
+	}
+
+	positions[point] = newPos;
+	stretchEdges(point);
+	move(root, point, oldPos, p, 1);
+	return true;
+}
+
+// stretchEdges:  keep maxEdge covering the triangles around a moved vertex
+//
+void Octree::stretchEdges(int point) {
+	if (point + 1 >= int(faceStart.size())) return;
+	for (int i = faceStart[point]; i < faceStart[point + 1]; i++) {
+		int t = vertexFaces[i] * 3;
+		for (int k = 0; k < 3; k++) {
+			maxEdge = std::max(maxEdge, glm::length(vertices[faces[t + k]] - vertices[faces[t + (k + 1) % 3]]));
+		}
+	}
+}
+
+void Octree::move(TreeNode & node, int point, const Vector3 & oldPos, const Vector3 & newPos, int level) {
+	if (node.children.size() < 1) return;
+
+	// children that only held the old position lose the point,
+	// children that hold both pass the move further down
+	//
+	for (int i = 0; i < int(node.children.size()); ) {
+		TreeNode & child = node.children[i];
+		bool inOld = child.box.inside(oldPos);
+		bool inNew = child.box.inside(newPos);
+		if (inOld && inNew) {
+			move(child, point, oldPos, newPos, level + 1);
+		}
+		else if (inOld) {
+			remove(child, point, oldPos);
+		}
+		if (isEmpty(child)) {
+			node.children.erase(node.children.begin() + i);
+		}
+		else i++;
+	}
+
+	// octants that now hold the new position.  A child box can differ
+	// from its octant by rounding after growRoot(), so check what the
+	// child holds rather than the octant box before inserting.
+	//
+	Box boxList[8];
+	subDivideBox8(node.box, boxList);
+	for (int i = 0; i < 8; i++) {
+		if (boxList[i].inside(newPos)) {
+			TreeNode & child = childFor(node, boxList[i]);
+			if (!holds(child, point, newPos))
+				insert(child, point, newPos, level + 1);
+		}
+	}
+}
+
+// childFor:  return the child of node with the given octant box, adding
+// an empty child if that octant is not populated yet
+//
+TreeNode & Octree::childFor(TreeNode & node, const Box & box) {
+	Box octant = box;
+	Vector3 c = octant.center();
+	for (int i = 0; i < node.children.size(); i++) {
+		if (node.children[i].box.inside(c)) return node.children[i];
+	}
+	TreeNode child;
+	child.box = box;
+	node.children.push_back(child);
+	return node.children.back();
+}
+
+// holds:  true if point is stored in the subtree of node
+//
+bool Octree::holds(TreeNode & node, int point, const Vector3 & p) {
+	if (node.children.size() < 1) {
+		return find(node.points.begin(), node.points.end(), point) != node.points.end();
+	}
+	for (int i = 0; i < node.children.size(); i++) {
+		if (node.children[i].box.inside(p) && holds(node.children[i], point, p)) return true;
+	}
+	return false;
+}
+
+// merge:  collapse the children of node into node if the subtree has
+// fallen to mergeThreshold points or less
+//
+void Octree::merge(TreeNode & node) {
+	if (node.children.size() < 1 || countPoints(node, mergeThreshold) > mergeThreshold) return;
+	collectPoints(node, node.points);
+	sort(node.points.begin(), node.points.end());
+	node.points.erase(unique(node.points.begin(), node.points.end()), node.points.end());
+	node.children.clear();
+}
+
+// countPoints:  number of points in the leaves under node (points on
+// shared faces are counted once per leaf).  Stops as soon as the count
+// is over limit, so checking a big subtree against a small threshold
+// doesn't walk all of it.
+//
+int Octree::countPoints(const TreeNode & node, int limit) const {
+	if (node.children.size() < 1) return node.points.size();
+	int count = 0;
+	for (int i = 0; i < int(node.children.size()) && count <= limit; i++) {
+		count += countPoints(node.children[i], limit - count);
+	}
+	return count;
+}
+
+void Octree::collectPoints(const TreeNode & node, vector<int> & pointsRtn) const {
+	if (node.children.size() < 1) {
+		pointsRtn.insert(pointsRtn.end(), node.points.begin(), node.points.end());
+		return;
+	}
+	for (int i = 0; i < node.children.size(); i++) {
+		collectPoints(node.children[i], pointsRtn);
+	}
+}
+
+// growRoot:  double the root box toward p; the old root becomes one of
+// the octants of the new root.  One level is added so leaves keep
+// the same resolution.
+//
+void Octree::growRoot(const Vector3 & p) {
+	Vector3 min = root.box.min();
+	Vector3 max = root.box.max();
+	Vector3 size = max - min;
+	Vector3 newMin = Vector3(p.x() < min.x() ? min.x() - size.x() : min.x(),
+		p.y() < min.y() ? min.y() - size.y() : min.y(),
+		p.z() < min.z() ? min.z() - size.z() : min.z());
+
+	TreeNode newRoot;
+	newRoot.box = Box(newMin, newMin + size * 2);
+	if (!isEmpty(root)) newRoot.children.push_back(root);
+	root = newRoot;
+	maxLevels++;
+}
+
+// makeLean:  drop the point lists of the interior nodes before the first
+// incremental update
+//
+void Octree::makeLean() {
+	if (bLean) return;
+	bLean = true;
+	dropInteriorPoints(root);
+}
+
+void Octree::dropInteriorPoints(TreeNode & node) {
+	if (node.children.size() < 1) return;
+	vector<int>().swap(node.points);
+	for (int i = 0; i < int(node.children.size()); i++) dropInteriorPoints(node.children[i]);
+}
+
+// makeWritable:  switch from an external vertex buffer to the tree's own
+// copy before the first modification
+//
+void Octree::makeWritable() {
+	if (vertices != positions.data()) {
+		positions.assign(vertices, vertices + numVertices);
+		vertices = positions.data();
+	}
+}
+
+// memoryUsage:  bytes held by the tree - nodes, point lists and the
+// vertex positions if the tree owns them
+//
+size_t Octree::memoryUsage() const {
+	size_t bytes = sizeof(Octree) + nodeMemoryUsage(root);
+	if (vertices == positions.data()) bytes += positions.capacity() * sizeof(glm::vec3);
+	bytes += (faces.capacity() + faceStart.capacity() + vertexFaces.capacity()) * sizeof(int);
+	return bytes;
+}
+
+size_t Octree::nodeMemoryUsage(const TreeNode & node) const {
+	size_t bytes = node.points.capacity() * sizeof(int) + node.children.capacity() * sizeof(TreeNode);
+	for (int i = 0; i < node.children.size(); i++) {
+		bytes += nodeMemoryUsage(node.children[i]);
+	}
+	return bytes;
+}
+
+float Octree::bytesPerVertex() const {
+	if (numVertices < 1) return 0;
+	return float(memoryUsage()) / numVertices;
+}
+
 // Implement functions below for Homework project
 //
 
-bool Octree::intersect(const Ray &ray, const TreeNode & node, TreeNode & nodeRtn) {
+bool Octree::intersect(const Ray &ray, const TreeNode & node, TreeNode & nodeRtn, QueryStats * stats, int level) const {
 	bool intersects = false;
+	QUERY_COUNT(stats, boxTests, 1);
 	if (node.box.intersect(ray, 0, 100000000000000000)) {
+		QUERY_COUNT(stats, nodesVisited, 1);
+		QUERY_DEPTH(stats, level);
 		if (node.children.size() < 1) {
+			QUERY_COUNT(stats, leavesReached, 1);
 			nodeRtn = node;
 		}
 		else {
 			for (int i = 0; i < node.children.size(); i++) {
-				intersect(ray, node.children[i], nodeRtn);
+				intersect(ray, node.children[i], nodeRtn, stats, level + 1);
 			}
 		}
 		intersects = true;
@@ -206,15 +675,19 @@ bool Octree::intersect(const Ray &ray, const TreeNode & node, TreeNode & nodeRtn
 	return intersects;
 }
 
-bool Octree::intersect(const Box &box, TreeNode & node, vector<Box> & boxListRtn) {
+bool Octree::intersect(const Box &box, const TreeNode & node, vector<Box> & boxListRtn, QueryStats * stats, int level) const {
 	bool intersects = false;
+	QUERY_COUNT(stats, boxTests, 1);
 	if (node.box.overlap(box)) {
+		QUERY_COUNT(stats, nodesVisited, 1);
+		QUERY_DEPTH(stats, level);
 		if (node.children.size() < 1) {
+			QUERY_COUNT(stats, leavesReached, 1);
 			boxListRtn.push_back(node.box);
 		}
 		else {
 			for (int i = 0; i < node.children.size(); i++) {
-				intersect(box, node.children[i], boxListRtn);
+				intersect(box, node.children[i], boxListRtn, stats, level + 1);
 			}
 		}
 		intersects = true;
@@ -225,6 +698,321 @@ bool Octree::intersect(const Box &box, TreeNode & node, vector<Box> & boxListRtn
 	return intersects;
 }
 
+// intersect:  same as above for an oriented box
+//
+bool Octree::intersect(const OBB &box, const TreeNode & node, vector<Box> & boxListRtn, QueryStats * stats, int level) const {
+	bool intersects = false;
+	QUERY_COUNT(stats, boxTests, 1);
+	if (box.overlap(node.box)) {
+		QUERY_COUNT(stats, nodesVisited, 1);
+		QUERY_DEPTH(stats, level);
+		if (node.children.size() < 1) {
+			QUERY_COUNT(stats, leavesReached, 1);
+			boxListRtn.push_back(node.box);
+		}
+		else {
+			for (int i = 0; i < node.children.size(); i++) {
+				intersect(box, node.children[i], boxListRtn, stats, level + 1);
+			}
+		}
+		intersects = true;
+	}
+	else {
+		intersects = false;
+	}
+	return intersects;
+}
+
+//
+// SpatialIndex queries
+//
+
+// rayQuery:  the closest triangle hit when the tree was created from a
+// mesh.  Over bare points, find the first non-empty leaf along the ray
+// (smallest entry distance) and return its point closest to the ray.
+//
+bool Octree::rayQuery(const Ray & ray, glm::vec3 & pointRtn, QueryStats * stats) const {
+	QUERY_COUNT(stats, queries, 1);
+	if (!faces.empty()) return rayQueryTriangles(ray, pointRtn, stats);
+
+	float tBest = FLT_MAX;
+	const TreeNode * leaf = NULL;
+	rayQuery(ray, root, tBest, leaf, stats, 0);
+	if (leaf == NULL) return false;
+	QUERY_COUNT(stats, results, 1);
+
+	glm::vec3 o = glm::vec3(ray.origin.x(), ray.origin.y(), ray.origin.z());
+	glm::vec3 d = glm::normalize(glm::vec3(ray.direction.x(), ray.direction.y(), ray.direction.z()));
+	float best = FLT_MAX;
+	for (int i = 0; i < int(leaf->points.size()); i++) {
+		glm::vec3 v = vertices[leaf->points[i]] - o;
+		glm::vec3 perp = v - d * glm::dot(v, d);
+		float dist2 = glm::dot(perp, perp);
+		if (dist2 < best) {
+			best = dist2;
+			pointRtn = vertices[leaf->points[i]];
+		}
+	}
+	return true;
+}
+
+// rayQueryTriangles:  closest hit on the mesh's triangles.  Every point
+// of a triangle is within maxEdge of its corners and each corner is in a
+// leaf, so the hit lies in a leaf box grown by maxEdge.  Grown boxes are
+// opened nearest entry first, the triangles around the points of each
+// leaf tested, and the search stops once the next box starts beyond the
+// best hit.
+//
+bool Octree::rayQueryTriangles(const Ray & ray, glm::vec3 & pointRtn, QueryStats * stats) const {
+	glm::vec3 o = glm::vec3(ray.origin.x(), ray.origin.y(), ray.origin.z());
+	glm::vec3 d = glm::vec3(ray.direction.x(), ray.direction.y(), ray.direction.z());
+	Vector3 margin = Vector3(maxEdge, maxEdge, maxEdge);
+	auto grown = [&](const Box & box) { return Box(box.parameters[0] - margin, box.parameters[1] + margin); };
+
+	// (entry distance, (node, level))
+	//
+	typedef pair<float, pair<const TreeNode *, int> > NodeEntry;
+	FrameArenaScope scratch;
+	priority_queue<NodeEntry, FrameVector<NodeEntry>, greater<NodeEntry> > nodeQueue;
+
+	float tBest = FLT_MAX;
+	float t;
+	QUERY_COUNT(stats, boxTests, 1);
+	if (grown(root.box).intersect(ray, 0, tBest, t)) nodeQueue.push(NodeEntry(t, make_pair(&root, 0)));
+	while (!nodeQueue.empty()) {
+		NodeEntry entry = nodeQueue.top();
+		nodeQueue.pop();
+		if (entry.first >= tBest) break;
+
+		const TreeNode & node = *entry.second.first;
+		int level = entry.second.second;
+		QUERY_COUNT(stats, nodesVisited, 1);
+		QUERY_DEPTH(stats, level);
+		if (node.children.size() > 0) {
+			QUERY_COUNT(stats, boxTests, node.children.size());
+			for (int i = 0; i < node.children.size(); i++) {
+				if (grown(node.children[i].box).intersect(ray, 0, tBest, t))
+					nodeQueue.push(NodeEntry(t, make_pair(&node.children[i], level + 1)));
+			}
+			continue;
+		}
+		QUERY_COUNT(stats, leavesReached, 1);
+
+		glm::vec3 a, b, c;
+		for (int i = 0; i < int(node.points.size()); i++) {
+			int p = node.points[i];
+			if (p + 1 >= int(faceStart.size())) continue;
+			for (int k = faceStart[p]; k < faceStart[p + 1]; k++) {
+				triangle(vertexFaces[k], a, b, c);
+				if (rayTriangle(o, d, a, b, c, t) && t < tBest) tBest = t;
+			}
+		}
+	}
+	if (tBest == FLT_MAX) return false;
+	pointRtn = o + d * tBest;
+	QUERY_COUNT(stats, results, 1);
+	return true;
+}
+
+void Octree::rayQuery(const Ray & ray, const TreeNode & node, float & tBest, const TreeNode * & leafRtn, QueryStats * stats, int level) const {
+	float t;
+	QUERY_COUNT(stats, boxTests, 1);
+	if (!node.box.intersect(ray, 0, tBest, t)) return;
+	QUERY_COUNT(stats, nodesVisited, 1);
+	QUERY_DEPTH(stats, level);
+	if (node.children.size() < 1) {
+		QUERY_COUNT(stats, leavesReached, 1);
+		if (node.points.size() > 0 && t < tBest) {
+			tBest = t;
+			leafRtn = &node;
+		}
+		return;
+	}
+	for (int i = 0; i < node.children.size(); i++) {
+		rayQuery(ray, node.children[i], tBest, leafRtn, stats, level + 1);
+	}
+}
+
+// boxQuery:  append the leaf boxes overlapping box, true if there were any
+//
+bool Octree::boxQuery(const Box & box, vector<Box> & boxListRtn, QueryStats * stats) const {
+	int n = boxListRtn.size();
+	QUERY_COUNT(stats, queries, 1);
+	intersect(box, root, boxListRtn, stats);
+	QUERY_COUNT(stats, results, boxListRtn.size() - n);
+	return int(boxListRtn.size()) > n;
+}
+
+// boxQuery:  same for an oriented box
+//
+bool Octree::boxQuery(const OBB & box, vector<Box> & boxListRtn, QueryStats * stats) const {
+	int n = boxListRtn.size();
+	QUERY_COUNT(stats, queries, 1);
+	intersect(box, root, boxListRtn, stats);
+	QUERY_COUNT(stats, results, boxListRtn.size() - n);
+	return int(boxListRtn.size()) > n;
+}
+
+// triangleQuery:  the triangles around the points of the leaves the box
+// overlaps.  The tree holds points, not triangles, so the box is first
+// grown by the longest edge:  a triangle reaching into the box then has
+// all its vertices inside the grown box, even when none is inside box.
+//
+int Octree::triangleQuery(const OBB & box, vector<int> & trianglesRtn, QueryStats * stats) const {
+	QUERY_COUNT(stats, queries, 1);
+	if (faces.empty()) return 0;
+	OBB grown = box;
+	grown.halfExtents = box.halfExtents + Vector3(maxEdge, maxEdge, maxEdge);
+	FrameArenaScope scratch;
+	FrameVector<int> points;
+	leafPoints(grown, root, points, stats, 0);
+
+	int n = trianglesRtn.size();
+	for (int i = 0; i < points.size(); i++) {
+		int p = points[i];
+		if (p + 1 >= int(faceStart.size())) continue;
+		for (int k = faceStart[p]; k < faceStart[p + 1]; k++) trianglesRtn.push_back(vertexFaces[k]);
+	}
+	sort(trianglesRtn.begin() + n, trianglesRtn.end());
+	trianglesRtn.erase(unique(trianglesRtn.begin() + n, trianglesRtn.end()), trianglesRtn.end());
+
+	int kept = n;
+	glm::vec3 a, b, c;
+	for (int i = n; i < int(trianglesRtn.size()); i++) {
+		triangle(trianglesRtn[i], a, b, c);
+		if (triangleOverlaps(box, a, b, c)) trianglesRtn[kept++] = trianglesRtn[i];
+	}
+	trianglesRtn.resize(kept);
+	QUERY_COUNT(stats, results, kept - n);
+	return kept - n;
+}
+
+void Octree::leafPoints(const OBB & box, const TreeNode & node, FrameVector<int> & pointsRtn, QueryStats * stats, int level) const {
+	QUERY_COUNT(stats, boxTests, 1);
+	if (!box.overlap(node.box)) return;
+	QUERY_COUNT(stats, nodesVisited, 1);
+	QUERY_DEPTH(stats, level);
+	if (node.children.size() < 1) {
+		QUERY_COUNT(stats, leavesReached, 1);
+		pointsRtn.insert(pointsRtn.end(), node.points.begin(), node.points.end());
+		return;
+	}
+	for (int i = 0; i < node.children.size(); i++) {
+		leafPoints(box, node.children[i], pointsRtn, stats, level + 1);
+	}
+}
+
+// nearestPoint:  single nearest neighbor, see knn()
+//
+bool Octree::nearestPoint(const glm::vec3 & p, int & pointRtn, QueryStats * stats) const {
+	vector<int> points;
+	pointRtn = -1;
+	if (knn(p, 1, points, stats) < 1) return false;
+	pointRtn = points[0];
+	return true;
+}
+
+// knn:  best-first search.  Nodes wait in a priority queue ordered by the
+// distance from p to their box; the k best points so far are kept in a
+// max-heap.  The search stops once the nearest waiting box is further
+// away than the k-th best point, so only the nodes around p are opened.
+//
+int Octree::knn(const glm::vec3 & p, int k, vector<int> & pointsRtn, QueryStats * stats) const {
+	pointsRtn.clear();
+	QUERY_COUNT(stats, queries, 1);
+	if (k < 1 || (root.points.size() < 1 && root.children.size() < 1)) return 0;
+
+	// (box distance, (node, level))
+	//
+	typedef pair<float, pair<const TreeNode *, int> > NodeEntry;
+	typedef pair<float, int> PointEntry;
+	FrameArenaScope scratch;
+	priority_queue<NodeEntry, FrameVector<NodeEntry>, greater<NodeEntry> > nodeQueue;
+	priority_queue<PointEntry, FrameVector<PointEntry> > best;
+
+	Vector3 q = Vector3(p.x, p.y, p.z);
+	QUERY_COUNT(stats, boxTests, 1);
+	nodeQueue.push(NodeEntry(root.box.distance2(q), make_pair(&root, 0)));
+	while (!nodeQueue.empty()) {
+		NodeEntry entry = nodeQueue.top();
+		nodeQueue.pop();
+		if (int(best.size()) == k && entry.first >= best.top().first) break;
+
+		const TreeNode & node = *entry.second.first;
+		int level = entry.second.second;
+		QUERY_COUNT(stats, nodesVisited, 1);
+		QUERY_DEPTH(stats, level);
+		if (node.children.size() > 0) {
+			QUERY_COUNT(stats, boxTests, node.children.size());
+			for (int i = 0; i < node.children.size(); i++) {
+				float d = node.children[i].box.distance2(q);
+				if (int(best.size()) < k || d < best.top().first)
+					nodeQueue.push(NodeEntry(d, make_pair(&node.children[i], level + 1)));
+			}
+			continue;
+		}
+		QUERY_COUNT(stats, leavesReached, 1);
+
+		for (int i = 0; i < int(node.points.size()); i++) {
+			glm::vec3 v = vertices[node.points[i]] - p;
+			float d = glm::dot(v, v);
+			if (int(best.size()) == k && d >= best.top().first) continue;
+
+			// points on a shared face live in more than one leaf
+			//
+			if (find(pointsRtn.begin(), pointsRtn.end(), node.points[i]) != pointsRtn.end()) continue;
+			best.push(PointEntry(d, node.points[i]));
+			pointsRtn.push_back(node.points[i]);
+			if (int(best.size()) > k) {
+				pointsRtn.erase(find(pointsRtn.begin(), pointsRtn.end(), best.top().second));
+				best.pop();
+			}
+		}
+	}
+
+	// heap holds furthest on top - unload it back to front
+	//
+	pointsRtn.resize(best.size());
+	for (int i = best.size() - 1; i >= 0; i--) {
+		pointsRtn[i] = best.top().second;
+		best.pop();
+	}
+	QUERY_COUNT(stats, results, pointsRtn.size());
+	return pointsRtn.size();
+}
+
+// pointsInRadius:  every point within radius of p; subtrees whose box is
+// further than radius from p are skipped
+//
+int Octree::pointsInRadius(const glm::vec3 & p, float radius, vector<int> & pointsRtn, QueryStats * stats) const {
+	pointsRtn.clear();
+	QUERY_COUNT(stats, queries, 1);
+	pointsInRadius(root, Vector3(p.x, p.y, p.z), radius * radius, pointsRtn, stats, 0);
+	sort(pointsRtn.begin(), pointsRtn.end());
+	pointsRtn.erase(unique(pointsRtn.begin(), pointsRtn.end()), pointsRtn.end());
+	QUERY_COUNT(stats, results, pointsRtn.size());
+	return pointsRtn.size();
+}
+
+void Octree::pointsInRadius(const TreeNode & node, const Vector3 & p, float radius2, vector<int> & pointsRtn, QueryStats * stats, int level) const {
+	QUERY_COUNT(stats, boxTests, 1);
+	if (node.box.distance2(p) > radius2) return;
+	QUERY_COUNT(stats, nodesVisited, 1);
+	QUERY_DEPTH(stats, level);
+	if (node.children.size() < 1) {
+		QUERY_COUNT(stats, leavesReached, 1);
+		glm::vec3 q = glm::vec3(p.x(), p.y(), p.z());
+		for (int i = 0; i < int(node.points.size()); i++) {
+			glm::vec3 v = vertices[node.points[i]] - q;
+			if (glm::dot(v, v) <= radius2) pointsRtn.push_back(node.points[i]);
+		}
+		return;
+	}
+	for (int i = 0; i < node.children.size(); i++) {
+		pointsInRadius(node.children[i], p, radius2, pointsRtn, stats, level + 1);
+	}
+}
+
 void Octree::draw(TreeNode & node, int numLevels, int level) {
 	if (level >= numLevels) return;
 	drawBox(node.box);
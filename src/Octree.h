@@ -12,6 +12,8 @@
 #include "ofMain.h"
 #include "box.h"
 #include "ray.h"
+#include "SpatialIndex.h"
+#include "FrameArena.h"
 
 
 
@@ -22,13 +24,49 @@ public:
 	vector<TreeNode> children;
 };
 
-class Octree {
+// summary of the last create(), see Octree::report
+//
+class OctreeBuildReport {
+public:
+	int depth = 0;
+	int numNodes = 0;
+	int numLeaves = 0;
+	int maxLeafPoints = 0;
+	float avgLeafPoints = 0;
+	float buildTime = 0;      // ms
+};
+
+class Octree : public SpatialIndex {
 public:
 	
+	// SpatialIndex
+	//
+	void build(const ofMesh & mesh) { create(mesh, maxLevels > 0 ? maxLevels : 10); }
+	bool rayQuery(const Ray & ray, glm::vec3 & pointRtn, QueryStats * stats = NULL) const;
+	bool boxQuery(const Box & box, vector<Box> & boxListRtn, QueryStats * stats = NULL) const;
+	bool boxQuery(const OBB & box, vector<Box> & boxListRtn, QueryStats * stats = NULL) const;
+	bool nearestPoint(const glm::vec3 & p, int & pointRtn, QueryStats * stats = NULL) const;
+	int triangleQuery(const OBB & box, vector<int> & trianglesRtn, QueryStats * stats = NULL) const;
+	void triangle(int t, glm::vec3 & a, glm::vec3 & b, glm::vec3 & c) const {
+		a = vertices[faces[t * 3]];
+		b = vertices[faces[t * 3 + 1]];
+		c = vertices[faces[t * 3 + 2]];
+	}
+	string name() const { return "octree"; }
+
+	// nearest neighbor queries - indices of the k points closest to p
+	// (nearest first), and of all points within radius of p.  Both
+	// return the number of points found.
+	//
+	int knn(const glm::vec3 & p, int k, vector<int> & pointsRtn, QueryStats * stats = NULL) const;
+	int pointsInRadius(const glm::vec3 & p, float radius, vector<int> & pointsRtn, QueryStats * stats = NULL) const;
+
 	void create(const ofMesh & mesh, int numLevels);
-	void subdivide(const ofMesh & mesh, TreeNode & node, int numLevels, int level);
-	bool intersect(const Ray &, const TreeNode & node, TreeNode & nodeRtn);
-	bool intersect(const Box &, TreeNode & node, vector<Box> & boxListRtn);
+	void create(const glm::vec3 * verts, int n, int numLevels);
+	void subdivide(TreeNode & node, int numLevels, int level);
+	bool intersect(const Ray &, const TreeNode & node, TreeNode & nodeRtn, QueryStats * stats = NULL, int level = 0) const;
+	bool intersect(const Box &, const TreeNode & node, vector<Box> & boxListRtn, QueryStats * stats = NULL, int level = 0) const;
+	bool intersect(const OBB &, const TreeNode & node, vector<Box> & boxListRtn, QueryStats * stats = NULL, int level = 0) const;
 	void draw(TreeNode & node, int numLevels, int level);
 	void draw(int numLevels, int level) {
 		draw(root, numLevels, level);
@@ -36,16 +74,105 @@ public:
 	void drawLeafNodes(TreeNode & node);
 	static void drawBox(const Box &box);
 	static Box meshBounds(const ofMesh &);
-	int getMeshPointsInBox(const ofMesh &mesh, const vector<int> & points, Box & box, vector<int> & pointsRtn);
-	int getMeshFacesInBox(const ofMesh &mesh, const vector<int> & faces, Box & box, vector<int> & facesRtn);
+	static Box pointBounds(const glm::vec3 * points, int n);
+	int getMeshPointsInBox(const ofMesh &mesh, const vector<int> & points, const Box & box, vector<int> & pointsRtn) const;
+	int getPointsInBox(const vector<int> & points, const Box & box, vector<int> & pointsRtn) const;
+	int getMeshFacesInBox(const ofMesh &mesh, const vector<int> & faces, const Box & box, vector<int> & facesRtn) const;
 	void subDivideBox8(const Box &b, vector<Box> & boxList);
+	static void subDivideBox8(const Box &b, Box boxesRtn[8]);
+
+	// incremental updates - only the nodes along the affected
+	// paths are split, merged or pruned (no full rebuild).  They
+	// switch the tree to lean mode.
+	//
+	int insert(const ofVec3f & point);
+	bool insert(int point);
+	bool remove(int point);
+	bool move(int point, const ofVec3f & newPos);
+
+	// memory report - total bytes and bytes per indexed vertex
+	//
+	size_t memoryUsage() const;
+	float bytesPerVertex() const;
+
+	const glm::vec3 & vertex(int i) const { return vertices[i]; }
+
+	// vertex positions the tree indexes into; either points at positions
+	// (the tree's own compact copy) or at an external read-only buffer
+	//
+	const glm::vec3 * vertices = NULL;
+	int numVertices = 0;
+	vector<glm::vec3> positions;
 
-	ofMesh mesh;
 	TreeNode root;
 	bool bUseFaces = false;
 
+	// the mesh's triangles (3 vertex indices each) and, per vertex, the
+	// triangles using it:  those of vertex i are
+	// vertexFaces[faceStart[i] .. faceStart[i + 1]).  Only create() from
+	// a mesh fills them in; the tree itself still holds points.
+	//
+	vector<int> faces;
+	vector<int> faceStart;
+	vector<int> vertexFaces;
+	float maxEdge = 0;        // longest triangle edge
+
+	// lean mode - interior nodes drop their point lists after the build,
+	// only leaves keep the indices of the points they contain
+	//
+	bool bLean = false;
+
+	// occupancy thresholds used by the incremental updates.  A leaf
+	// above maxLevels is split once it holds more than maxLeafPoints;
+	// an interior node collapses back into a leaf once its subtree
+	// holds mergeThreshold points or less.  The defaults reproduce
+	// the full-depth tree that create() builds.
+	//
+	int maxLevels = 0;
+	int maxLeafPoints = 0;
+	int mergeThreshold = 0;
+
+	// further termination criteria for subdivide().  A node is not split
+	// once its box is smaller than minExtent on every axis, or - when
+	// bUseSAH is set - when the surface area heuristic says testing the
+	// children costs more than testing the points in the node:
+	//
+	//    split cost = traversalCost + sum(area(child) / area(node) * intersectCost * points(child))
+	//    leaf cost  = intersectCost * points(node)
+	//
+	float minExtent = 0;
+	bool bUseSAH = false;
+	float traversalCost = 1.0;
+	float intersectCost = 1.0;
+
+	OctreeBuildReport report;
+
 	// debug;
 	//
 	int strayVerts= 0;
 	int numLeaf = 0;
+
+private:
+	void insert(TreeNode & node, int point, const Vector3 & p, int level);
+	bool remove(TreeNode & node, int point, const Vector3 & p);
+	void move(TreeNode & node, int point, const Vector3 & oldPos, const Vector3 & newPos, int level);
+	TreeNode & childFor(TreeNode & node, const Box & box);
+	bool holds(TreeNode & node, int point, const Vector3 & p);
+	void merge(TreeNode & node);
+	int countPoints(const TreeNode & node, int limit) const;
+	void collectPoints(const TreeNode & node, vector<int> & pointsRtn) const;
+	bool isEmpty(const TreeNode & node) const { return node.points.size() < 1 && node.children.size() < 1; }
+	void growRoot(const Vector3 & p);
+	bool splitWorthIt(const TreeNode & node, const Box * boxList, const vector<int> * childPoints);
+	void buildReport(const TreeNode & node, int level);
+	bool rayQueryTriangles(const Ray & ray, glm::vec3 & pointRtn, QueryStats * stats) const;
+	void rayQuery(const Ray & ray, const TreeNode & node, float & tBest, const TreeNode * & leafRtn, QueryStats * stats, int level) const;
+	void pointsInRadius(const TreeNode & node, const Vector3 & p, float radius2, vector<int> & pointsRtn, QueryStats * stats, int level) const;
+	void makeWritable();
+	void makeLean();
+	void dropInteriorPoints(TreeNode & node);
+	void indexFaces(const ofMesh & mesh);
+	void stretchEdges(int point);
+	void leafPoints(const OBB & box, const TreeNode & node, FrameVector<int> & pointsRtn, QueryStats * stats, int level) const;
+	size_t nodeMemoryUsage(const TreeNode & node) const;
 };
\ No newline at end of file
@@ -21,7 +21,7 @@ Particle::Particle() {
 	color = ofColor::whiteSmoke;
 }
 
-void Particle::draw() {
+void Particle::draw() const {
 	ofSetColor(color);
 	ofDrawSphere(position, radius);
 }
@@ -33,7 +33,13 @@ void Particle::integrate() {
 	
 	// interval for this step
 	//
-	float dt = 1.0 / ofGetFrameRate();
+	integrate(1.0 / ofGetFrameRate());
+}
+
+// integrate with an explicit time step (sec), for fixed step simulation
+// and for running without a window
+//
+void Particle::integrate(float dt) {
 
 	// update position based on velocity
 	//
@@ -63,10 +69,10 @@ void Particle::integrate() {
 	angularForce = 0;
 }
 
-//  return age in seconds
+//  return age in seconds, now being the time of the particle's system
 //
-float Particle::age() {
-	return (ofGetElapsedTimeMillis() - birthtime)/1000.0;
+float Particle::age(float now) const {
+	return now - birthtime;
 }
 
 
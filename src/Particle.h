@@ -16,14 +16,15 @@ public:
 	float   mass;
 	float   lifespan;
 	float   radius;
-	float   birthtime;
+	float   birthtime;    // sec, on its system's clock
 	float   rotation;
 	float   angularForce;
 	float   angularVelocity;
 	float   angularAccleration;
 	void    integrate();
-	void    draw();
-	float   age();        // sec
+	void    integrate(float dt);
+	void    draw() const;
+	float   age(float now) const;   // sec, now on its system's clock
 	ofColor color;
 };
 
@@ -0,0 +1,98 @@
+//--------------------------------------------------------------
+//
+//  ParticleBudget
+//
+//--------------------------------------------------------------
+
+#include "ParticleBudget.h"
+
+void ParticleBudget::add(ParticleEmitter * emitter, int priority, float share) {
+	BudgetEntry e;
+	e.emitter = emitter;
+	e.priority = priority;
+	e.share = share;
+	int i = 0;
+	while (i < int(entries.size()) && entries[i].priority >= priority) i++;
+	entries.insert(entries.begin() + i, e);
+}
+
+int ParticleBudget::total() const {
+	int n = 0;
+	for (int i = 0; i < int(entries.size()); i++) n += entries[i].emitter->sys->particles.size();
+	return n;
+}
+
+// updateQuality:  smooth the frame time, then step quality down fast when
+// over the target and back up slowly when under it
+//
+void ParticleBudget::updateQuality(float frameMs) {
+	if (frameMs <= 0) return;
+	avgFrameMs = avgFrameMs > 0 ? avgFrameMs * 0.9 + frameMs * 0.1 : frameMs;
+	if (avgFrameMs > targetFrameMs * 1.05) quality = max(minQuality, quality * 0.95f);
+	else if (avgFrameMs <= targetFrameMs) quality = min(1.0f, quality * 1.01f);
+}
+
+// demand:  the most the emitter can spawn in its next update (one group)
+//
+int ParticleBudget::demand(const BudgetEntry & e) const {
+	const ParticleEmitter & em = *e.emitter;
+	if (!em.started || (em.oneShot && em.fired)) return 0;
+	if (!em.oneShot && em.rate <= 0) return 0;
+	return em.scaledGroupSize();
+}
+
+void ParticleBudget::update(float frameMs) {
+	updateQuality(frameMs);
+
+	// lower priorities degrade first:  rank 0 (highest) of n scales by
+	// quality^(1/n), the lowest by quality itself
+	//
+	int n = entries.size();
+	for (int i = 0; i < n; i++) {
+		BudgetEntry & e = entries[i];
+		e.scale = pow(quality, float(i + 1) / n);
+		e.emitter->rateScale = e.scale;
+		e.emitter->lifespanScale = e.scale;
+	}
+
+	// already over the cap (it was lowered):  trim the lowest priorities
+	// back to their reservations first
+	//
+	int room = maxParticles - total();
+	trimmed = 0;
+	for (int j = n - 1; j >= 0 && room < 0; j--) {
+		ParticleSystem & sys = *entries[j].emitter->sys;
+		int k = min(int(sys.particles.size()) - reserved(entries[j]), -room);
+		if (k <= 0) continue;
+		sys.removeOldest(k);
+		room += k;
+		trimmed += k;
+	}
+
+	for (int i = 0; i < n; i++) {
+		BudgetEntry & e = entries[i];
+		int want = demand(e);
+		int count = e.emitter->sys->particles.size();
+		int grant = min(want, max(room, 0));
+
+		// short of the reservation:  take room back from the lowest
+		// priority emitters that are over theirs
+		//
+		int missing = min(want, reserved(e) - count) - grant;
+		for (int j = n - 1; j > i && missing > 0; j--) {
+			ParticleSystem & sys = *entries[j].emitter->sys;
+			int over = int(sys.particles.size()) - reserved(entries[j]);
+			int k = min(over, missing);
+			if (k <= 0) continue;
+			sys.removeOldest(k);
+			room += k;
+			missing -= k;
+			trimmed += k;
+		}
+		grant = min(want, max(room, 0));
+
+		e.allowance = grant;
+		e.emitter->spawnAllowance = grant;
+		room -= grant;
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  ParticleBudget
+//
+//  Description:
+//  One cap on the particles of all the emitters together.
+//  Each emitter is registered with a priority and a reserved
+//  share of the cap.  update() runs once per step, before the
+//  emitters update, and hands each emitter an allowance of
+//  particles it may spawn in that step:
+//
+//    - emitters are served in priority order (highest first),
+//      each up to the group it would spawn, from the room
+//      left under the cap;
+//    - an emitter still short of its reserved share takes the
+//      room back from lower priority emitters over theirs,
+//      oldest particles first.
+//
+//  So the total never exceeds maxParticles.  The emitters
+//  then update in parallel, each only looking at its own
+//  allowance.
+//
+//  Under frame time pressure (the smoothed frame time over
+//  targetFrameMs) a quality factor drops, and recovers slowly
+//  once the frames fit in the target again.  It scales the emitters'
+//  spawn rates, group sizes and lifespans, the lowest
+//  priority the most.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+#include "ParticleEmitter.h"
+
+class BudgetEntry {
+public:
+	ParticleEmitter * emitter;
+	int priority;
+	float share;                    // of maxParticles, reserved
+	float scale = 1;                // rate / lifespan scale this step
+	int allowance = 0;              // particles granted this step
+};
+
+class ParticleBudget {
+public:
+	// register an emitter; shares should add up to 1 or less
+	//
+	void add(ParticleEmitter * emitter, int priority, float share);
+
+	// serial, once per step before the emitters update.  frameMs is the
+	// time the last frame spent working (0 = unknown, the quality is left
+	// alone); not the time between frames, which vertical sync holds at
+	// the refresh interval however little work there was.
+	//
+	void update(float frameMs);
+
+	int total() const;
+	int reserved(const BudgetEntry & e) const { return int(e.share * maxParticles); }
+
+	int maxParticles = 3000;
+	float targetFrameMs = 1000.0 / 60;
+	float minQuality = 0.25;
+
+	float quality = 1;              // 1 = full rates and lifespans
+	float avgFrameMs = 0;           // smoothed
+	int trimmed = 0;                // particles taken back, last update()
+
+	vector<BudgetEntry> entries;    // highest priority first
+
+private:
+	void updateQuality(float frameMs);
+	int demand(const BudgetEntry & e) const;
+};
@@ -40,6 +40,10 @@ void ParticleEmitter::init() {
 	visible = true;
 	type = DirectionalEmitter;
 	groupSize = 1;
+	coneAngle = 15;
+	rateScale = 1;
+	lifespanScale = 1;
+	spawnAllowance = INT_MAX;
 }
 
 
@@ -62,7 +66,7 @@ void ParticleEmitter::draw() {
 }
 void ParticleEmitter::start() {
 	started = true;
-	lastSpawned = ofGetElapsedTimeMillis();
+	lastSpawned = sys->time;
 }
 
 void ParticleEmitter::stop() {
@@ -70,16 +74,22 @@ void ParticleEmitter::stop() {
 	fired = false;
 }
 void ParticleEmitter::update() {
+	update(1.0 / ofGetFrameRate());
+}
+
+// update with an explicit time step (sec), for fixed step simulation.
+// Spawning goes by the particle system's clock, which the steps advance.
+//
+void ParticleEmitter::update(float dt) {
 
-	float time = ofGetElapsedTimeMillis();
+	float time = sys->time;
 
 	if (oneShot && started) {
 		if (!fired) {
 
 			// spawn a new particle(s)
 			//
-			for (int i = 0; i < groupSize; i++)
-				spawn(time);
+			spawnBudgeted(time);
 
 			lastSpawned = time;
 		}
@@ -87,52 +97,89 @@ void ParticleEmitter::update() {
 		stop();
 	}
 
-	else if (((time - lastSpawned) > (1000.0 / rate)) && started) {
+	else if (((time - lastSpawned) >= (1.0 / (rate * rateScale))) && started) {
 
 		// spawn a new particle(s)
 		//
-		for (int i= 0; i < groupSize; i++)
-			spawn(time);
-	
+		spawnBudgeted(time);
+
 		lastSpawned = time;
 	}
 
-	sys->update();
+	sys->update(dt);
+}
+
+// spawnBudgeted:  a group, cut down to what the budget still allows
+//
+void ParticleEmitter::spawnBudgeted(float time) {
+	int n = min(scaledGroupSize(), spawnAllowance);
+	if (n < 1) return;
+	spawnGroup(time, n);
+	if (spawnAllowance != INT_MAX) spawnAllowance -= n;
 }
 
 // spawn a single particle.  time is current time of birth
 //
 void ParticleEmitter::spawn(float time) {
+	spawnGroup(time, 1);
+}
 
-	Particle particle;
+void ParticleEmitter::spawnGroup(float time, int n) {
+	if (n < 1) return;
 
-	// set initial velocity and position
-	// based on emitter type
+	// sample initial positions and velocities based on emitter type
 	//
+	EmitterShape s = shape();
 	switch (type) {
+	case DirectionalEmitter:
+		DirectionalShape::sample(s, n, batch);
+		break;
 	case RadialEmitter:
-	{
-		ofVec3f dir = ofVec3f(ofRandom(-1, 1), ofRandom(-1, 1), ofRandom(-1, 1));
-		float speed = velocity.length();
-		particle.velocity = dir.getNormalized() * speed;
-		particle.position.set(position);
-	}
-	break;
+		RadialShape::sample(s, n, batch);
+		break;
 	case SphereEmitter:
+		SphereSurfaceShape::sample(s, n, batch);
 		break;
-	case DirectionalEmitter:
-		particle.velocity = velocity;
-		particle.position.set(position);
+	case SphereVolumeEmitter:
+		SphereVolumeShape::sample(s, n, batch);
+		break;
+	case ConeEmitter:
+		ConeShape::sample(s, n, batch);
+		break;
+	case DiskEmitter:
+		DiskShape::sample(s, n, batch);
 		break;
 	}
+	addBatch(time, n);
+}
+
+EmitterShape ParticleEmitter::shape() const {
+	EmitterShape s;
+	s.position = glm::vec3(position.x, position.y, position.z);
+	s.velocity = glm::vec3(velocity.x, velocity.y, velocity.z);
+	s.radius = radius;
+	s.coneAngle = coneAngle;
+	return s;
+}
+
+// addBatch:  add the first n sampled particles to the system
+//
+void ParticleEmitter::addBatch(float time, int n) {
+	vector<Particle> & particles = sys->particles;
+	if (particles.capacity() < particles.size() + n) {
+		particles.reserve(max(particles.size() + n, 2 * particles.capacity()));
+	}
 
 	// other particle attributes
 	//
-	particle.lifespan = lifespan;
+	Particle particle;
+	particle.lifespan = lifespan * lifespanScale;
 	particle.birthtime = time;
 	particle.radius = particleRadius;
 
-	// add to system
-	//
-	sys->add(particle);
+	for (int i = 0; i < n; i++) {
+		particle.position.set(batch.px[i], batch.py[i], batch.pz[i]);
+		particle.velocity.set(batch.vx[i], batch.vy[i], batch.vz[i]);
+		particles.push_back(particle);
+	}
 }
@@ -3,8 +3,9 @@
 
 #include "TransformObject.h"
 #include "ParticleSystem.h"
+#include "EmitterShape.h"
 
-typedef enum { DirectionalEmitter, RadialEmitter, SphereEmitter } EmitterType;
+typedef enum { DirectionalEmitter, RadialEmitter, SphereEmitter, SphereVolumeEmitter, ConeEmitter, DiskEmitter } EmitterType;
 
 //  General purpose Emitter class for emitting sprites
 //  This works similar to a Particle emitter
@@ -13,7 +14,7 @@ class ParticleEmitter : public TransformObject {
 public:
 	ParticleEmitter();
 	ParticleEmitter(ParticleSystem* s);
-	~ParticleEmitter();
+	virtual ~ParticleEmitter();
 	void init();
 	void draw();
 	void start();
@@ -26,7 +27,15 @@ public:
 	void setGroupSize(int s) { groupSize = s; }
 	void setOneShot(bool s) { oneShot = s; }
 	void update();
+	void update(float dt);
+	// time of birth (sec) on sys's clock
+	//
 	void spawn(float time);
+
+	// spawn n particles at once, sampled with the shape for type (one
+	// switch per group, not per particle)
+	//
+	virtual void spawnGroup(float time, int n);
 	ParticleSystem* sys;
 	float rate;         // per sec
 	bool oneShot;
@@ -34,11 +43,38 @@ public:
 	ofVec3f velocity;
 	float lifespan;     // sec
 	bool started;
-	float lastSpawned;  // ms
+	float lastSpawned;  // sec, on sys's clock
 	float particleRadius;
 	float radius;
 	bool visible;
 	int groupSize;      // number of particles to spawn in a group
 	bool createdSys;
 	EmitterType type;
+	float coneAngle;    // deg, ConeEmitter
+
+	// set by a ParticleBudget each step:  rate, group size and lifespan
+	// scale, and how many particles the next update may still spawn
+	//
+	float rateScale;
+	float lifespanScale;
+	int spawnAllowance;
+	int scaledGroupSize() const { return max(1, int(groupSize * (oneShot ? rateScale : 1) + 0.5f)); }
+
+protected:
+	EmitterShape shape() const;
+	void addBatch(float time, int n);
+	void spawnBudgeted(float time);
+	SpawnBatch batch;
+};
+
+//  Emitter with its shape fixed at compile time (see EmitterShape.h),
+//  e.g. ShapeEmitter<ConeShape> for a thruster.  type is ignored.
+//
+template <class Shape>
+class ShapeEmitter : public ParticleEmitter {
+public:
+	void spawnGroup(float time, int n) {
+		Shape::sample(shape(), n, batch);
+		addBatch(time, n);
+	}
 };
@@ -2,6 +2,21 @@
 // Kevin M.Smith - CS 134 SJSU
 
 #include "ParticleSystem.h"
+#include <atomic>
+#include <random>
+
+float threadRandom(float min, float max) {
+	static atomic<unsigned> seeds(1);
+	thread_local minstd_rand gen(seeds++);
+	float t = (gen() - gen.min()) / float(gen.max() - gen.min());
+	return min + (max - min) * t;
+}
+
+// n draws at once, for the emitter shapes' batch sampling
+//
+void threadRandomFill(float * out, int n, float min, float max) {
+	for (int i = 0; i < n; i++) out[i] = threadRandom(min, max);
+}
 
 void ParticleSystem::add(const Particle& p) {
 	particles.push_back(p);
@@ -15,6 +30,14 @@ void ParticleSystem::remove(int i) {
 	particles.erase(particles.begin() + i);
 }
 
+// removeOldest:  particles are appended as they spawn, so the oldest
+// are at the front
+//
+void ParticleSystem::removeOldest(int n) {
+	n = min(n, int(particles.size()));
+	if (n > 0) particles.erase(particles.begin(), particles.begin() + n);
+}
+
 void ParticleSystem::setLifespan(float l) {
 	for (int i = 0; i < particles.size(); i++) {
 		particles[i].lifespan = l;
@@ -28,6 +51,14 @@ void ParticleSystem::reset() {
 }
 
 void ParticleSystem::update() {
+	update(1.0 / ofGetFrameRate());
+}
+
+// update with an explicit time step (sec)
+//
+void ParticleSystem::update(float dt) {
+	time += dt;
+
 	// check if empty and just return
 	if (particles.size() == 0) return;
 
@@ -39,7 +70,7 @@ void ParticleSystem::update() {
 	// traversing at the same time, we need to use an iterator.
 	//
 	while (p != particles.end()) {
-		if (p->lifespan != -1 && p->age() > p->lifespan) {
+		if (p->lifespan != -1 && p->age(time) > p->lifespan) {
 			tmp = particles.erase(p);
 			p = tmp;
 		}
@@ -66,7 +97,7 @@ void ParticleSystem::update() {
 	// integrate all the particles in the store
 	//
 	for (int i = 0; i < particles.size(); i++)
-		particles[i].integrate();
+		particles[i].integrate(dt);
 
 }
 
@@ -108,9 +139,9 @@ void TurbulenceForce::updateForce(Particle* particle) {
 	// We are going to add a little "noise" to a particles
 	// forces to achieve a more natual look to the motion
 	//
-	particle->forces.x += ofRandom(tmin.x, tmax.x);
-	particle->forces.y += ofRandom(tmin.y, tmax.y);
-	particle->forces.z += ofRandom(tmin.z, tmax.z);
+	particle->forces.x += threadRandom(tmin.x, tmax.x);
+	particle->forces.y += threadRandom(tmin.y, tmax.y);
+	particle->forces.z += threadRandom(tmin.z, tmax.z);
 }
 
 // Impulse Radial Force - this is a "one shot" force that
@@ -126,7 +157,7 @@ void ImpulseRadialForce::updateForce(Particle* particle) {
 	// we basically create a random direction for each particle
 	// the force is only added once after it is triggered.
 	//
-	ofVec3f dir = ofVec3f(ofRandom(-1, 1), ofRandom(-1, 1), ofRandom(-height, height));
+	ofVec3f dir = ofVec3f(threadRandom(-1, 1), threadRandom(-1, 1), threadRandom(-height, height));
 	particle->forces += dir.getNormalized() * magnitude;
 }
 
@@ -4,6 +4,12 @@
 #include "ofMain.h"
 #include "Particle.h"
 
+// ofRandom() shares one generator between all threads; the emitters and
+// their forces update on job system workers, so they draw from a
+// generator of their own per thread.  Same range rules as ofRandom.
+//
+float threadRandom(float min, float max);
+void threadRandomFill(float * out, int n, float min, float max);
 
 //  Pure Virtual Function Class - must be subclassed to create new forces.
 //
@@ -21,12 +27,20 @@ public:
 	void addForce(ParticleForce*);
 	void remove(int);
 	void update();
+	void update(float dt);
 	void setLifespan(float);
 	void reset();
 	int removeNear(const ofVec3f& point, float dist);
+	void removeOldest(int n);
 	void draw();
 	vector<Particle> particles;
 	vector<ParticleForce*> forces;
+
+	// sec, the sum of the update() time steps:  particle birth times and
+	// ages are on this clock, so they follow the simulation's fixed step
+	// rather than the wall clock
+	//
+	float time = 0;
 };
 
 
@@ -38,6 +52,7 @@ class GravityForce : public ParticleForce {
 public:
 	GravityForce(const ofVec3f& gravity);
 	void updateForce(Particle*);
+	void set(const ofVec3f& g) { gravity = g; }
 };
 
 class TurbulenceForce : public ParticleForce {
@@ -45,6 +60,7 @@ class TurbulenceForce : public ParticleForce {
 public:
 	TurbulenceForce(const ofVec3f& min, const ofVec3f& max);
 	void updateForce(Particle*);
+	void set(const ofVec3f& min, const ofVec3f& max) { tmin = min; tmax = max; }
 };
 
 class DirectionalForce : public ParticleForce {
@@ -0,0 +1,202 @@
+//--------------------------------------------------------------
+//
+//  Profiler
+//
+//--------------------------------------------------------------
+
+#include "Profiler.h"
+#include <fstream>
+
+// small, stable per-thread number for the trace (thread ids themselves
+// are not printable in a portable way)
+//
+static int threadNumber() {
+	static atomic<int> nextThread(0);
+	thread_local int number = nextThread++;
+	return number;
+}
+
+Profiler & Profiler::instance() {
+	static Profiler profiler;
+	return profiler;
+}
+
+int64_t Profiler::now() {
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler::Profiler() {
+	enabled = false;
+	numZones = 0;
+	numCounters = 0;
+	for (int i = 0; i < maxZones; i++) current[i] = 0;
+	for (int i = 0; i < maxCounters; i++) counterCurrent[i] = 0;
+	memset(history, 0, sizeof(history));
+	memset(counterHistory, 0, sizeof(counterHistory));
+	trace.reset(new TraceEvent[traceSize]);
+	traceHead = 0;
+	startTime = frameStart = now();
+}
+
+// zoneId:  register a zone by name (once, from the PROFILE_SCOPE static);
+// zones past maxZones share the last slot
+//
+int Profiler::zoneId(const char * name) {
+	lock_guard<mutex> guard(lock);
+	for (int i = 0; i < numZones; i++) {
+		if (strcmp(names[i], name) == 0) return i;
+	}
+	if (numZones == maxZones) return maxZones - 1;
+	names[numZones] = name;
+	return numZones++;
+}
+
+int Profiler::counterId(const char * name) {
+	lock_guard<mutex> guard(lock);
+	for (int i = 0; i < numCounters; i++) {
+		if (strcmp(counterNames[i], name) == 0) return i;
+	}
+	if (numCounters == maxCounters) return maxCounters - 1;
+	counterNames[numCounters] = name;
+	return numCounters++;
+}
+
+void Profiler::add(int zone, int64_t start, int64_t ns) {
+	current[zone] += ns;
+
+	uint64_t slot = traceHead.fetch_add(1, memory_order_relaxed);
+	TraceEvent & e = trace[slot % traceSize];
+	e.sequence.store(2 * slot + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	e.zone.store(zone, memory_order_relaxed);
+	e.thread.store(threadNumber(), memory_order_relaxed);
+	e.start.store(start, memory_order_relaxed);
+	e.duration.store(ns, memory_order_relaxed);
+	e.sequence.store(2 * slot + 2, memory_order_release);
+}
+
+// endFrame:  close the current frame - call once per frame from the main
+// thread, before any zone of the next frame opens
+//
+void Profiler::endFrame() {
+	int64_t t = now();
+	int64_t * row = history[numFrames % historySize];
+	for (int i = 0; i < maxZones; i++) {
+		row[i] = current[i].exchange(0);
+	}
+	row[maxZones] = t - frameStart;
+	int64_t * counterRow = counterHistory[numFrames % historySize];
+	for (int i = 0; i < maxCounters; i++) {
+		counterRow[i] = counterCurrent[i].exchange(0);
+	}
+	frameStart = t;
+	numFrames++;
+}
+
+// draw:  per zone average / max over the history and the last frame, in ms
+//
+void Profiler::draw(float x, float y) {
+	if (!bShowOverlay) return;
+
+	int frames = min(numFrames, historySize);
+	if (frames < 1) return;
+	int last = (numFrames - 1) % historySize;
+
+	char line[128];
+	ofSetColor(ofColor::yellow);
+	int64_t frameTotal = 0;
+	for (int f = 0; f < frames; f++) frameTotal += history[f][maxZones];
+	snprintf(line, sizeof(line), "%-22s %7s %7s %7s", "zone (ms)", "last", "avg", "max");
+	ofDrawBitmapString(line, ofPoint(x, y));
+	y += 15;
+	snprintf(line, sizeof(line), "%-22s %7.2f %7.2f", "frame", history[last][maxZones] / 1e6, frameTotal / 1e6 / frames);
+	ofDrawBitmapString(line, ofPoint(x, y));
+	y += 15;
+
+	for (int i = 0; i < numZones; i++) {
+		int64_t total = 0;
+		int64_t peak = 0;
+		for (int f = 0; f < frames; f++) {
+			total += history[f][i];
+			peak = max(peak, history[f][i]);
+		}
+		snprintf(line, sizeof(line), "%-22.22s %7.3f %7.3f %7.3f", names[i],
+			history[last][i] / 1e6, total / 1e6 / frames, peak / 1e6);
+		ofDrawBitmapString(line, ofPoint(x, y));
+		y += 15;
+	}
+
+	if (numCounters > 0) {
+		y += 5;
+		snprintf(line, sizeof(line), "%-22s %7s %7s %7s", "counter / frame", "last", "avg", "max");
+		ofDrawBitmapString(line, ofPoint(x, y));
+		y += 15;
+	}
+	for (int i = 0; i < numCounters; i++) {
+		int64_t total = 0;
+		int64_t peak = 0;
+		for (int f = 0; f < frames; f++) {
+			total += counterHistory[f][i];
+			peak = max(peak, counterHistory[f][i]);
+		}
+		snprintf(line, sizeof(line), "%-22.22s %7lld %7.1f %7lld", counterNames[i],
+			(long long)counterHistory[last][i], double(total) / frames, (long long)peak);
+		ofDrawBitmapString(line, ofPoint(x, y));
+		y += 15;
+	}
+	ofSetColor(ofColor::white);
+}
+
+// dumpCSV:  one row per frame in the history, oldest first, times in ms
+// followed by the counters
+//
+bool Profiler::dumpCSV(const string & path) {
+	ofstream out(path.c_str());
+	if (!out.is_open()) return false;
+
+	out << "frame,frame_ms";
+	for (int i = 0; i < numZones; i++) out << "," << names[i];
+	for (int i = 0; i < numCounters; i++) out << "," << counterNames[i];
+	out << endl;
+
+	int frames = min(numFrames, historySize);
+	for (int f = numFrames - frames; f < numFrames; f++) {
+		int64_t * row = history[f % historySize];
+		out << f << "," << row[maxZones] / 1e6;
+		for (int i = 0; i < numZones; i++) out << "," << row[i] / 1e6;
+		for (int i = 0; i < numCounters; i++) out << "," << counterHistory[f % historySize][i];
+		out << endl;
+	}
+	return true;
+}
+
+// dumpTrace:  the most recent zone instances as Chrome trace events;
+// load the file in chrome://tracing or ui.perfetto.dev
+//
+bool Profiler::dumpTrace(const string & path) {
+	ofstream out(path.c_str());
+	if (!out.is_open()) return false;
+
+	// events still being written (or already overwritten by newer ones)
+	// are left out
+	//
+	uint64_t head = traceHead.load(memory_order_acquire);
+	uint64_t count = min(head, uint64_t(traceSize));
+	int written = 0;
+	out << "{\"traceEvents\":[" << endl;
+	for (uint64_t slot = head - count; slot < head; slot++) {
+		const TraceEvent & e = trace[slot % traceSize];
+		uint64_t sequence = e.sequence.load(memory_order_acquire);
+		if (sequence != 2 * slot + 2) continue;
+		int zone = e.zone.load(memory_order_relaxed);
+		int thread = e.thread.load(memory_order_relaxed);
+		int64_t start = e.start.load(memory_order_relaxed);
+		int64_t duration = e.duration.load(memory_order_relaxed);
+		atomic_thread_fence(memory_order_acquire);
+		if (e.sequence.load(memory_order_relaxed) != sequence) continue;
+		out << (written++ > 0 ? ",\n" : "") << "{\"name\":\"" << names[zone] << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread
+			<< ",\"ts\":" << (start - startTime) / 1000.0 << ",\"dur\":" << duration / 1000.0 << "}";
+	}
+	out << endl << "]}" << endl;
+	return true;
+}
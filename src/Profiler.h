@@ -0,0 +1,139 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  Profiler
+//
+//  Description:
+//  Scoped timing zones for the per-frame hot paths.  Each zone
+//  accumulates nanoseconds into the current frame; endFrame()
+//  moves the totals into a ring buffer of the last frames,
+//  which the overlay averages and dumpCSV() writes out.  Every
+//  zone instance is also kept as a trace event for
+//  dumpTrace() (chrome://tracing format).
+//
+//  Usage:   { PROFILE_SCOPE("emitter.update"); emitter.update(); }
+//
+//  Counters (PROFILE_COUNT) are summed per frame the same way
+//  and shown below the zones.  PROFILE_MAX keeps the largest
+//  value reported in the frame instead, for levels (a depth, a
+//  total) that must not add up over the several simulation
+//  steps one frame can hold.
+//
+//  Build with LANDER_PROFILE=0 to compile every zone out; at
+//  runtime, zones cost one flag test while enabled is false,
+//  which it is until the overlay is shown (O in game).
+//
+//  Trace events go into a ring buffer without a lock:  each
+//  zone claims a slot with an atomic increment of the head, so
+//  the job threads being measured aren't serialized on it.  A
+//  slot carries the sequence number it was written for, and
+//  dumpTrace() skips any slot a zone is rewriting meanwhile.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#ifndef LANDER_PROFILE
+#define LANDER_PROFILE 1
+#endif
+
+class Profiler {
+public:
+	static const int maxZones = 32;
+	static const int maxCounters = 32;
+	static const int historySize = 240;     // frames
+	static const int traceSize = 65536;     // events
+
+	static Profiler & instance();
+	static int64_t now();                   // ns, steady clock
+
+	int zoneId(const char * name);
+	void add(int zone, int64_t start, int64_t ns);
+	int counterId(const char * name);
+	void count(int counter, int64_t n) { if (enabled) counterCurrent[counter] += n; }
+	void peak(int counter, int64_t n) {
+		if (!enabled) return;
+		int64_t old = counterCurrent[counter];
+		while (n > old && !counterCurrent[counter].compare_exchange_weak(old, n)) { }
+	}
+	void endFrame();
+
+	void draw(float x, float y);
+	bool dumpCSV(const string & path);
+	bool dumpTrace(const string & path);
+
+	atomic<bool> enabled;
+	bool bShowOverlay = false;
+
+private:
+	Profiler();
+
+	// sequence:  2 * slot + 1 while being written, 2 * slot + 2 once done
+	//
+	class TraceEvent {
+	public:
+		atomic<uint64_t> sequence { 0 };
+		atomic<int> zone { 0 };
+		atomic<int> thread { 0 };
+		atomic<int64_t> start { 0 };
+		atomic<int64_t> duration { 0 };
+	};
+
+	mutex lock;
+	const char * names[maxZones];
+	atomic<int> numZones;
+	atomic<int64_t> current[maxZones];
+
+	// history[frame % historySize][zone], the last column is frame time
+	//
+	int64_t history[historySize][maxZones + 1];
+
+	const char * counterNames[maxCounters];
+	atomic<int> numCounters;
+	atomic<int64_t> counterCurrent[maxCounters];
+	int64_t counterHistory[historySize][maxCounters];
+	int numFrames = 0;
+	int64_t frameStart = 0;
+	int64_t startTime = 0;
+
+	unique_ptr<TraceEvent[]> trace;
+	atomic<uint64_t> traceHead;     // events ever added
+};
+
+class ProfileZone {
+public:
+	ProfileZone(int zone) {
+		this->zone = zone;
+		start = Profiler::instance().enabled ? Profiler::now() : 0;
+	}
+	~ProfileZone() {
+		if (start != 0) Profiler::instance().add(zone, start, Profiler::now() - start);
+	}
+
+private:
+	int zone;
+	int64_t start;
+};
+
+#if LANDER_PROFILE
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(name) \
+	static const int PROFILE_CONCAT(profileZoneId, __LINE__) = Profiler::instance().zoneId(name); \
+	ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(PROFILE_CONCAT(profileZoneId, __LINE__))
+#define PROFILE_COUNT(name, n) do { \
+	static const int profileCounterId = Profiler::instance().counterId(name); \
+	Profiler::instance().count(profileCounterId, n); } while (0)
+#define PROFILE_MAX(name, n) do { \
+	static const int profileCounterId = Profiler::instance().counterId(name); \
+	Profiler::instance().peak(profileCounterId, n); } while (0)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(name, n) do { } while (0)
+#define PROFILE_MAX(name, n) do { } while (0)
+#endif
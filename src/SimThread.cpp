@@ -0,0 +1,45 @@
+//--------------------------------------------------------------
+//
+//  SimThread
+//
+//--------------------------------------------------------------
+
+#include "SimThread.h"
+#include <chrono>
+
+void SimThread::start(float rate, function<void(float)> step) {
+	if (running()) return;
+	this->rate = rate;
+	this->step = step;
+	bQuit = false;
+	worker = thread(&SimThread::loop, this);
+}
+
+void SimThread::stop() {
+	if (!running()) return;
+	bQuit = true;
+	worker.join();
+}
+
+void SimThread::loop() {
+	typedef chrono::steady_clock Clock;
+	Clock::duration period = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / rate));
+	Clock::time_point next = Clock::now();
+	float dt = 1.0 / rate;
+
+	while (!bQuit) {
+		step(dt);
+		steps++;
+
+		// sleep to the next tick; if already past it, run the next step
+		// straight away, unless far enough behind to give up on catching up
+		//
+		next += period;
+		Clock::time_point now = Clock::now();
+		if (now - next > period * maxCatchUp) {
+			dropped += int((now - next) / period);
+			next = now;
+		}
+		this_thread::sleep_until(next);
+	}
+}
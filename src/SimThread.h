@@ -0,0 +1,87 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  SimThread
+//
+//  Description:
+//  Runs the simulation step on its own thread at a fixed rate,
+//  independent of the render frame rate.  The render thread
+//  sends its input (SimInput) and gets back the state to draw
+//  (SimSnapshot) through triple buffers, so neither thread
+//  waits for the other.
+//
+//  If the thread falls more than maxCatchUp steps behind (a
+//  debugger break, a stalled machine) the missed steps are
+//  dropped instead of run back to back.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+#include "Particle.h"
+#include "SpatialIndex.h"
+#include "Narrowphase.h"
+#include <atomic>
+#include <functional>
+#include <thread>
+
+// render thread -> sim:  key state, sent once per render frame
+//
+class SimInput {
+public:
+	bool simulation = false;
+	bool forward = false;
+	bool back = false;
+	bool left = false;
+	bool right = false;
+	bool thrust = false;
+	bool rotateLeft = false;
+	bool rotateRight = false;
+	bool restart = false;
+	int releases = 0;               // key releases so far, each one cuts the thrusters
+	float frameMs = 0;              // last render frame's work (not the vsync wait), for the particle budget
+};
+
+// sim -> render thread:  everything draw() needs from one step
+//
+class SimSnapshot {
+public:
+	int step = 0;
+	glm::vec3 landerPosition = glm::vec3(0, 100, 100);
+	float landerRotation = 0;       // deg about y
+	glm::vec3 landerVelocity = glm::vec3(0, 0, 0);
+	float altitude = 100;           // lander bottom above the ground
+	int fuel = 12000;
+	bool thrusterIsOn = false;
+	bool died = false;
+	bool youWon = false;
+	int crashes = 0;                // crash sounds to play, so far
+	vector<Particle> exhaust;       // emitter
+	vector<Particle> explosion;     // emitter2
+	QueryStats queryStats;          // all terrain queries so far
+	vector<Contact> contacts;       // lander / terrain, this step
+};
+
+class SimThread {
+public:
+	static const int maxCatchUp = 5;
+
+	~SimThread() { stop(); }
+
+	// call step(dt) rate times a second until stop()
+	//
+	void start(float rate, function<void(float)> step);
+	void stop();
+	bool running() const { return worker.joinable(); }
+
+	float rate = 60;
+	atomic<int> steps { 0 };
+	atomic<int> dropped { 0 };      // steps skipped to catch up
+
+private:
+	void loop();
+
+	thread worker;
+	atomic<bool> bQuit { false };
+	function<void(float)> step;
+};
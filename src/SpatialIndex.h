@@ -0,0 +1,124 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  SpatialIndex
+//
+//  Description:
+//  Common interface for the terrain acceleration structures
+//  (Octree, BVH) so the app and tools can swap one for the
+//  other per asset.
+//
+//  Queries are const and keep no state between calls, so any
+//  number of threads may query one index at once as long as
+//  nothing rebuilds it meanwhile.  Results (and QueryStats) go
+//  to the caller's buffers; give each thread its own.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+#include "box.h"
+#include "ray.h"
+
+// QueryStats:  work done by queries, for spotting pathological queries
+// and comparing tree layouts.  Pass one to a query to have that query
+// counted into it; totals over many queries are built with add().
+// Compile with QUERY_STATS=0 to take the counting out of the queries.
+//
+#ifndef QUERY_STATS
+#define QUERY_STATS 1
+#endif
+
+#if QUERY_STATS
+#define QUERY_COUNT(stats, field, n) do { if (stats) (stats)->field += (n); } while (0)
+#define QUERY_DEPTH(stats, level) do { if ((stats) && (level) > (stats)->maxDepth) (stats)->maxDepth = (level); } while (0)
+#else
+#define QUERY_COUNT(stats, field, n) do { } while (0)
+#define QUERY_DEPTH(stats, level) do { } while (0)
+#endif
+
+class QueryStats {
+public:
+	int queries = 0;
+	int nodesVisited = 0;     // nodes whose box passed the test
+	int boxTests = 0;         // slab, overlap and distance tests against node boxes
+	int leavesReached = 0;
+	int results = 0;
+	int maxDepth = 0;
+
+	void add(const QueryStats & s) {
+		queries += s.queries;
+		nodesVisited += s.nodesVisited;
+		boxTests += s.boxTests;
+		leavesReached += s.leavesReached;
+		results += s.results;
+		maxDepth = max(maxDepth, s.maxDepth);
+	}
+	void clear() { *this = QueryStats(); }
+};
+
+class SpatialIndex {
+public:
+	virtual ~SpatialIndex() { }
+
+	// build the index over the vertices (and faces) of a mesh
+	//
+	virtual void build(const ofMesh & mesh) = 0;
+
+	// ray query:  first point where the ray meets the indexed triangles.
+	// An index over bare points (an Octree created without a mesh) has
+	// no surface; it returns the vertex of the first leaf hit closest to
+	// the ray instead.
+	//
+	virtual bool rayQuery(const Ray & ray, glm::vec3 & pointRtn, QueryStats * stats = NULL) const = 0;
+
+	// box query:  bounding boxes of all leaves that overlap box
+	//
+	virtual bool boxQuery(const Box & box, vector<Box> & boxListRtn, QueryStats * stats = NULL) const = 0;
+
+	// same for an oriented box (separating axis test at each node), for
+	// a rotated lander whose axis-aligned bounds would be too loose
+	//
+	virtual bool boxQuery(const OBB & box, vector<Box> & boxListRtn, QueryStats * stats = NULL) const = 0;
+
+	// nearest point:  index of the mesh vertex closest to p
+	//
+	virtual bool nearestPoint(const glm::vec3 & p, int & pointRtn, QueryStats * stats = NULL) const = 0;
+
+	// triangle query:  the mesh triangles whose bounds overlap box, for
+	// the narrow phase (see Narrowphase.h).  Appends their numbers and
+	// returns how many; triangle() gives their corners.
+	//
+	virtual int triangleQuery(const OBB & box, vector<int> & trianglesRtn, QueryStats * stats = NULL) const = 0;
+	virtual void triangle(int t, glm::vec3 & a, glm::vec3 & b, glm::vec3 & c) const = 0;
+
+	virtual size_t memoryUsage() const = 0;
+	virtual string name() const = 0;
+
+protected:
+	// Moller-Trumbore:  distance along d (not normalized) to the hit
+	//
+	static bool rayTriangle(const glm::vec3 & o, const glm::vec3 & d, const glm::vec3 & a,
+		const glm::vec3 & b, const glm::vec3 & c, float & t) {
+		glm::vec3 e1 = b - a;
+		glm::vec3 e2 = c - a;
+		glm::vec3 p = glm::cross(d, e2);
+		float det = glm::dot(e1, p);
+		if (fabs(det) < 1e-8) return false;
+		float inv = 1.0 / det;
+		glm::vec3 s = o - a;
+		float u = glm::dot(s, p) * inv;
+		if (u < 0 || u > 1) return false;
+		glm::vec3 q = glm::cross(s, e1);
+		float v = glm::dot(d, q) * inv;
+		if (v < 0 || u + v > 1) return false;
+		t = glm::dot(e2, q) * inv;
+		return t > 0;
+	}
+
+	static bool triangleOverlaps(const OBB & box, const glm::vec3 & a, const glm::vec3 & b, const glm::vec3 & c) {
+		glm::vec3 min = glm::min(a, glm::min(b, c));
+		glm::vec3 max = glm::max(a, glm::max(b, c));
+		return box.overlap(Box(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z)));
+	}
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  SpscQueue
+//
+//  Description:
+//  Fixed size lock-free ring from one producer thread to one
+//  consumer thread.  push() fails when the ring is full and
+//  pop() when it is empty; neither ever waits or allocates.
+//  Holds N - 1 values.
+//
+//--------------------------------------------------------------
+
+#include <atomic>
+
+template <class T, int N>
+class SpscQueue {
+public:
+	// producer
+	//
+	bool push(const T & value) {
+		int tail = tailIndex.load(std::memory_order_relaxed);
+		int next = (tail + 1) % N;
+		if (next == headIndex.load(std::memory_order_acquire)) return false;
+		slots[tail] = value;
+		tailIndex.store(next, std::memory_order_release);
+		return true;
+	}
+
+	// consumer
+	//
+	bool pop(T & value) {
+		int head = headIndex.load(std::memory_order_relaxed);
+		if (head == tailIndex.load(std::memory_order_acquire)) return false;
+		value = slots[head];
+		headIndex.store((head + 1) % N, std::memory_order_release);
+		return true;
+	}
+
+private:
+	T slots[N];
+	std::atomic<int> headIndex { 0 };   // next to pop, consumer only writes
+	std::atomic<int> tailIndex { 0 };   // next to push, producer only writes
+};
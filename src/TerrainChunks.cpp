@@ -0,0 +1,302 @@
+//--------------------------------------------------------------
+//
+//  TerrainChunks
+//
+//--------------------------------------------------------------
+
+#include "TerrainChunks.h"
+#include "MeshSimplifier.h"
+
+// compactMesh:  the triangles indices (into src) as a mesh of their own,
+// with only the vertices they use.  remap is scratch space, one entry
+// per src vertex, all -1 on entry and on return.
+//
+static void compactMesh(const ofMesh & src, const vector<int> & indices, vector<int> & remap, ofMesh & meshRtn) {
+	bool bNormals = src.getNumNormals() == src.getNumVertices();
+	bool bTexCoords = src.getNumTexCoords() == src.getNumVertices();
+	vector<int> used;
+	for (int i = 0; i < int(indices.size()); i++) {
+		int v = indices[i];
+		if (remap[v] < 0) {
+			remap[v] = used.size();
+			used.push_back(v);
+			meshRtn.addVertex(src.getVertex(v));
+			if (bNormals) meshRtn.addNormal(src.getNormal(v));
+			if (bTexCoords) meshRtn.addTexCoord(src.getTexCoord(v));
+		}
+		meshRtn.addIndex(remap[v]);
+	}
+	for (int i = 0; i < int(used.size()); i++) remap[used[i]] = -1;
+}
+
+// Gribb / Hartmann - the planes are sums and differences of the
+// rows of the model view projection matrix (glm is column major)
+//
+void Frustum::set(const glm::mat4 & mvp) {
+	glm::vec4 row[4];
+	for (int i = 0; i < 4; i++) {
+		row[i] = glm::vec4(mvp[0][i], mvp[1][i], mvp[2][i], mvp[3][i]);
+	}
+	planes[0] = row[3] + row[0];    // left
+	planes[1] = row[3] - row[0];    // right
+	planes[2] = row[3] + row[1];    // bottom
+	planes[3] = row[3] - row[1];    // top
+	planes[4] = row[3] + row[2];    // near
+	planes[5] = row[3] - row[2];    // far
+}
+
+// test the box corner furthest along each plane normal (outside if even
+// that one is behind a plane) and the corner opposite it (fully inside
+// if that one is in front of every plane)
+//
+int Frustum::classify(const Box & box) const {
+	const Vector3 & lo = box.parameters[0];
+	const Vector3 & hi = box.parameters[1];
+	int result = 1;
+	for (int i = 0; i < 6; i++) {
+		const glm::vec4 & p = planes[i];
+		float far = p.x * (p.x >= 0 ? hi.x() : lo.x()) + p.y * (p.y >= 0 ? hi.y() : lo.y()) +
+			p.z * (p.z >= 0 ? hi.z() : lo.z()) + p.w;
+		if (far < 0) return -1;
+		float near = p.x * (p.x >= 0 ? lo.x() : hi.x()) + p.y * (p.y >= 0 ? lo.y() : hi.y()) +
+			p.z * (p.z >= 0 ? lo.z() : hi.z()) + p.w;
+		if (near < 0) result = 0;
+	}
+	return result;
+}
+
+// build:  one chunk per octree cell at chunkLevel (or per leaf above it).
+// Each triangle goes to the chunk whose cell holds its centroid, so
+// chunks share no triangles; the chunk boxes are grown to fit the
+// triangles that stick out of their cells.
+//
+void TerrainChunks::build(const ofMesh & mesh, const Octree & octree, int chunkLevel) {
+	uint64_t t1 = ofGetElapsedTimeMicros();
+	chunks.clear();
+	nodes.clear();
+	visible.clear();
+	addNode(octree.root, 0, chunkLevel);
+
+	int numTriangles = mesh.hasIndices() ? mesh.getNumIndices() / 3 : mesh.getNumVertices() / 3;
+	vector<vector<int> > chunkTriangles(chunks.size());
+	for (int t = 0; t < numTriangles; t++) {
+		glm::vec3 c = glm::vec3(0, 0, 0);
+		for (int k = 0; k < 3; k++) {
+			int v = mesh.hasIndices() ? mesh.getIndex(t * 3 + k) : t * 3 + k;
+			c += mesh.getVertex(v);
+		}
+		c /= 3;
+		Vector3 centroid = Vector3(c.x, c.y, c.z);
+
+		// walk down to the nearest cell - empty octants have no node,
+		// so a centroid may fall outside all children
+		//
+		int n = 0;
+		while (nodes[n].children.size() > 0) {
+			int best = nodes[n].children[0];
+			float bestDist = FLT_MAX;
+			for (int i = 0; i < int(nodes[n].children.size()); i++) {
+				float d = nodes[nodes[n].children[i]].cell.distance2(centroid);
+				if (d < bestDist) {
+					bestDist = d;
+					best = nodes[n].children[i];
+				}
+			}
+			n = best;
+		}
+		chunkTriangles[nodes[n].chunk].push_back(t);
+	}
+
+	// chunk meshes with their own compact vertex arrays, then the
+	// simplified levels of each
+	//
+	vector<int> remap(mesh.getNumVertices(), -1);
+	vector<int> indices;
+	for (int i = 0; i < int(chunks.size()); i++) {
+		TerrainChunk & chunk = chunks[i];
+		const vector<int> & tris = chunkTriangles[i];
+		chunk.numTriangles = tris.size();
+		if (tris.size() < 1) continue;
+
+		indices.clear();
+		for (int t = 0; t < int(tris.size()); t++) {
+			for (int k = 0; k < 3; k++) {
+				indices.push_back(mesh.hasIndices() ? mesh.getIndex(tris[t] * 3 + k) : tris[t] * 3 + k);
+			}
+		}
+		chunk.lods.resize(1);
+		compactMesh(mesh, indices, remap, chunk.lods[0].mesh);
+		chunk.lods[0].numTriangles = tris.size();
+		chunk.box = Octree::pointBounds(chunk.lods[0].mesh.getVerticesPointer(), chunk.lods[0].mesh.getNumVertices());
+		buildLods(chunk);
+		for (int k = 0; k < int(chunk.lods.size()); k++) chunk.lods[k].mesh.setUsage(GL_STATIC_DRAW);
+	}
+	finish(0);
+
+	uint64_t t2 = ofGetElapsedTimeMicros();
+	buildTime = (t2 - t1) / 1000.0;
+}
+
+// buildLods:  each level keeps lodRatio of the triangles of the one
+// before.  Vertices on open edges - the chunk border and any seams in
+// the mesh - are locked.
+//
+void TerrainChunks::buildLods(TerrainChunk & chunk) {
+	chunk.lods.reserve(numLods);    // full is referenced while levels are added
+	const ofMesh & full = chunk.lods[0].mesh;
+	int n = full.getNumVertices();
+	vector<int> indices(full.getIndices().begin(), full.getIndices().end());
+
+	vector<pair<int, int> > edges;
+	for (int t = 0; t + 2 < int(indices.size()); t += 3) {
+		for (int k = 0; k < 3; k++) {
+			int a = indices[t + k];
+			int b = indices[t + (k + 1) % 3];
+			edges.push_back(pair<int, int>(min(a, b), max(a, b)));
+		}
+	}
+	sort(edges.begin(), edges.end());
+	vector<bool> locked(n, false);
+	for (int i = 0; i < int(edges.size());) {
+		int j = i;
+		while (j < int(edges.size()) && edges[j] == edges[i]) j++;
+		if (j - i != 2) {
+			locked[edges[i].first] = true;
+			locked[edges[i].second] = true;
+		}
+		i = j;
+	}
+
+	MeshSimplifier simplifier(full.getVertices(), indices, locked);
+	vector<int> remap(n, -1);
+	for (int level = 1; level < numLods; level++) {
+		int before = simplifier.numTriangles();
+		if (simplifier.simplify(before * lodRatio) >= before) break;
+
+		TerrainLod lod;
+		simplifier.getIndices(indices);
+		compactMesh(full, indices, remap, lod.mesh);
+		lod.numTriangles = simplifier.numTriangles();
+		lod.error = sqrt(simplifier.maxError);
+		chunk.lods.push_back(lod);
+	}
+}
+
+int TerrainChunks::addNode(const TreeNode & node, int level, int chunkLevel) {
+	int n = nodes.size();
+	nodes.push_back(ChunkNode());
+	nodes[n].cell = node.box;
+	if (level == chunkLevel || node.children.size() < 1) {
+		nodes[n].chunk = chunks.size();
+		chunks.push_back(TerrainChunk());
+		return n;
+	}
+	for (int i = 0; i < int(node.children.size()); i++) {
+		int child = addNode(node.children[i], level + 1, chunkLevel);
+		nodes[n].children.push_back(child);
+	}
+	return n;
+}
+
+// finish:  bottom up, set each node's box to the union of the triangle
+// bounds below it and flag the nodes with nothing to draw
+//
+int TerrainChunks::finish(int n) {
+	ChunkNode & node = nodes[n];
+	if (node.chunk >= 0) {
+		node.box = chunks[node.chunk].box;
+		node.empty = chunks[node.chunk].numTriangles < 1;
+		return chunks[node.chunk].numTriangles;
+	}
+	int total = 0;
+	for (int i = 0; i < int(node.children.size()); i++) {
+		const ChunkNode & child = nodes[node.children[i]];
+		int count = finish(node.children[i]);
+		if (count < 1) continue;
+		if (total == 0) {
+			node.box = child.box;
+		}
+		else {
+			const Vector3 & lo = node.box.parameters[0];
+			const Vector3 & hi = node.box.parameters[1];
+			const Vector3 & clo = child.box.parameters[0];
+			const Vector3 & chi = child.box.parameters[1];
+			node.box = Box(Vector3(min(lo.x(), clo.x()), min(lo.y(), clo.y()), min(lo.z(), clo.z())),
+				Vector3(max(hi.x(), chi.x()), max(hi.y(), chi.y()), max(hi.z(), chi.z())));
+		}
+		total += count;
+	}
+	node.empty = total < 1;
+	return total;
+}
+
+// cull:  mvp maps the terrain's model space to clip space (camera model
+// view projection times the terrain's model matrix)
+//
+void TerrainChunks::cull(const glm::mat4 & mvp) {
+	visible.clear();
+	visibleLods.clear();
+	chunksTested = 0;
+	chunksDrawn = 0;
+	trianglesDrawn = 0;
+	if (nodes.size() < 1) return;
+	frustum.set(mvp);
+	cull(0, false);
+}
+
+// subtrees fully inside the frustum are taken without further tests
+//
+void TerrainChunks::cull(int n, bool inside) {
+	const ChunkNode & node = nodes[n];
+	if (node.empty) return;
+	if (!inside) {
+		chunksTested++;
+		int c = frustum.classify(node.box);
+		if (c < 0) return;
+		inside = c > 0;
+	}
+	if (node.chunk >= 0) {
+		int lod = pickLod(chunks[node.chunk]);
+		visible.push_back(node.chunk);
+		visibleLods.push_back(lod);
+		chunksDrawn++;
+		trianglesDrawn += chunks[node.chunk].lods[lod].numTriangles;
+		return;
+	}
+	for (int i = 0; i < int(node.children.size()); i++) {
+		cull(node.children[i], inside);
+	}
+}
+
+void TerrainChunks::setView(const glm::vec3 & eye, float fov, float viewportHeight) {
+	this->eye = eye;
+	lodScale = viewportHeight / (2 * tan(ofDegToRad(fov) / 2));
+}
+
+// pickLod:  coarsest level whose error projects to at most maxPixelError
+// pixels at the distance from the eye to the chunk
+//
+int TerrainChunks::pickLod(const TerrainChunk & chunk) const {
+	if (lodScale <= 0) return 0;
+	float dist = max(sqrt(chunk.box.distance2(Vector3(eye.x, eye.y, eye.z))), 0.001f);
+	int lod = 0;
+	for (int i = 1; i < int(chunk.lods.size()); i++) {
+		if (chunk.lods[i].error * lodScale / dist > maxPixelError) break;
+		lod = i;
+	}
+	return lod;
+}
+
+void TerrainChunks::draw() {
+	if (bTexture) texture.bind();
+	for (int i = 0; i < int(visible.size()); i++) {
+		chunks[visible[i]].lods[visibleLods[i]].mesh.draw();
+	}
+	if (bTexture) texture.unbind();
+}
+
+void TerrainChunks::drawBoxes() {
+	for (int i = 0; i < int(visible.size()); i++) {
+		Octree::drawBox(chunks[visible[i]].box);
+	}
+}
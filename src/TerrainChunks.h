@@ -0,0 +1,110 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  TerrainChunks
+//
+//  Description:
+//  The terrain mesh split into chunks along the octree cells
+//  of one level, one VBO per chunk.  Each frame the chunk tree
+//  (the octree down to that level, with boxes grown to fit the
+//  triangles under them) is culled against the camera frustum
+//  and only the visible chunks are drawn.
+//
+//  Each chunk carries a few levels of detail, simplified at
+//  build time with MeshSimplifier.  The open edges of a chunk
+//  are locked during simplification, so every level of a chunk
+//  has the same border and neighbors at different levels meet
+//  without cracks.  The level drawn is the coarsest one whose
+//  error, projected to the screen at the chunk's distance,
+//  stays under maxPixelError.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+#include "Octree.h"
+
+// the six clip planes (a, b, c, d) of a view frustum; a point p is
+// inside when a * p.x + b * p.y + c * p.z + d >= 0 for every plane
+//
+class Frustum {
+public:
+	void set(const glm::mat4 & mvp);
+
+	// -1 box outside, 0 box straddles the frustum, 1 box fully inside
+	//
+	int classify(const Box & box) const;
+
+	glm::vec4 planes[6];
+};
+
+class TerrainLod {
+public:
+	ofVboMesh mesh;
+	int numTriangles = 0;
+	float error = 0;            // world units the surface may be off by
+};
+
+class TerrainChunk {
+public:
+	vector<TerrainLod> lods;    // lods[0] is the full mesh
+	Box box;                    // bounds of the chunk's triangles
+	int numTriangles = 0;       // at full detail
+};
+
+class ChunkNode {
+public:
+	Box cell;                   // octree cell, used to place triangles
+	Box box;                    // cell grown to the triangles below it
+	int chunk = -1;             // chunk of a node at the chunk level
+	bool empty = true;
+	vector<int> children;       // into TerrainChunks::nodes
+};
+
+class TerrainChunks {
+public:
+	void build(const ofMesh & mesh, const Octree & octree, int chunkLevel);
+	void cull(const glm::mat4 & mvp);
+	void draw();
+	void drawBoxes();
+
+	// viewer for the level of detail selection in cull() - eye in the
+	// terrain's model space, vertical field of view in degrees and the
+	// viewport height in pixels.  Without it cull() picks full detail.
+	//
+	void setView(const glm::vec3 & eye, float fov, float viewportHeight);
+
+	vector<TerrainChunk> chunks;
+	vector<ChunkNode> nodes;    // nodes[0] is the root
+	vector<int> visible;        // chunks that passed the last cull()
+	vector<int> visibleLods;    // and the level picked for each
+
+	// level of detail settings, numLods and lodRatio are used by build()
+	//
+	int numLods = 4;
+	float lodRatio = 0.5;       // triangles kept from one level to the next
+	float maxPixelError = 2.0;
+
+	ofTexture texture;
+	bool bTexture = false;
+
+	// stats of the last cull() - frustum tests against the chunk tree,
+	// and chunks and triangles that made it through
+	//
+	int chunksTested = 0;
+	int chunksDrawn = 0;
+	int trianglesDrawn = 0;
+
+	float buildTime = 0;        // ms
+
+private:
+	int addNode(const TreeNode & node, int level, int chunkLevel);
+	int finish(int node);
+	void cull(int node, bool inside);
+	void buildLods(TerrainChunk & chunk);
+	int pickLod(const TerrainChunk & chunk) const;
+
+	Frustum frustum;
+	glm::vec3 eye;
+	float lodScale = 0;         // pixels per world unit at distance 1
+};
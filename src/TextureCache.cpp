@@ -0,0 +1,378 @@
+//--------------------------------------------------------------
+//
+//  TextureCache
+//
+//--------------------------------------------------------------
+
+#include "TextureCache.h"
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static const char cacheMagic[4] = { 'L', 'T', 'C', 'M' };
+static const uint32_t cacheVersion = 1;
+
+//--------------------------------------------------------------
+//
+//  MappedFile
+//
+//--------------------------------------------------------------
+
+#ifdef _WIN32
+bool MappedFile::open(const string & path) {
+	close();
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		file = NULL;
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	size = fileSize.QuadPart;
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping != NULL) data = (const unsigned char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close() {
+	if (data != NULL) UnmapViewOfFile(data);
+	if (mapping != NULL) CloseHandle(mapping);
+	if (file != NULL) CloseHandle(file);
+	data = NULL;
+	mapping = NULL;
+	file = NULL;
+	size = 0;
+}
+#else
+bool MappedFile::open(const string & path) {
+	close();
+	fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close();
+		return false;
+	}
+	size = st.st_size;
+	void * p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (p == MAP_FAILED) {
+		close();
+		return false;
+	}
+	data = (const unsigned char *) p;
+	return true;
+}
+
+void MappedFile::close() {
+	if (data != NULL) munmap((void *) data, size);
+	if (fd >= 0) ::close(fd);
+	data = NULL;
+	fd = -1;
+	size = 0;
+}
+#endif
+
+//--------------------------------------------------------------
+//
+//  TextureCache
+//
+//--------------------------------------------------------------
+
+// halve an RGBA8 image with a 2x2 box filter (odd edges repeat the last
+// row / column)
+//
+static void downsample(const unsigned char * src, int w, int h, vector<unsigned char> & dst, int & wRtn, int & hRtn) {
+	wRtn = max(1, w / 2);
+	hRtn = max(1, h / 2);
+	dst.resize(size_t(wRtn) * hRtn * 4);
+	for (int y = 0; y < hRtn; y++) {
+		int y0 = min(y * 2, h - 1);
+		int y1 = min(y * 2 + 1, h - 1);
+		for (int x = 0; x < wRtn; x++) {
+			int x0 = min(x * 2, w - 1);
+			int x1 = min(x * 2 + 1, w - 1);
+			for (int c = 0; c < 4; c++) {
+				int sum = src[(size_t(y0) * w + x0) * 4 + c] + src[(size_t(y0) * w + x1) * 4 + c] +
+					src[(size_t(y1) * w + x0) * 4 + c] + src[(size_t(y1) * w + x1) * 4 + c];
+				dst[(size_t(y) * wRtn + x) * 4 + c] = (sum + 2) / 4;
+			}
+		}
+	}
+}
+
+string TextureCache::cachePath(const string & source) const {
+	string name = source;
+	for (int i = 0; i < int(name.size()); i++) {
+		if (name[i] == '/' || name[i] == '\\' || name[i] == ' ' || name[i] == ':') name[i] = '_';
+	}
+	return ofToDataPath(cacheDir + "/" + name + ".rgba", true);
+}
+
+bool TextureCache::sourceStamp(const string & path, uint64_t & size, uint64_t & time) {
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0) return false;
+	size = st.st_size;
+	time = st.st_mtime;
+	return true;
+}
+
+bool TextureCache::headerCurrent(const TextureCacheHeader & header, const string & source) {
+	if (memcmp(header.magic, cacheMagic, 4) != 0 || header.version != cacheVersion) return false;
+	if (header.numLevels < 1 || header.numLevels > TextureCacheHeader::maxLevels) return false;
+	uint64_t size, time;
+	if (!sourceStamp(ofToDataPath(source, true), size, time)) return true;    // cache only, source gone
+	return header.sourceSize == size && header.sourceTime == time;
+}
+
+// layoutValid:  the header describes the chain build() writes (each
+// level half the one before, down to 1x1 or maxLevels) and every level
+// lies inside the file.  A truncated or foreign file that gets past
+// headerCurrent() would otherwise have upload() read past the mapping.
+//
+bool TextureCache::layoutValid(const TextureCacheHeader & header, uint64_t fileSize) {
+	const uint32_t maxSize = 1 << 16;
+	if (header.width < 1 || header.height < 1 || header.width > maxSize || header.height > maxSize) return false;
+	uint64_t w = header.width;
+	uint64_t h = header.height;
+	uint32_t numLevels = 1;
+	while ((w > 1 || h > 1) && numLevels < TextureCacheHeader::maxLevels) {
+		w = max(w / 2, uint64_t(1));
+		h = max(h / 2, uint64_t(1));
+		numLevels++;
+	}
+	if (header.numLevels != numLevels) return false;
+
+	w = header.width;
+	h = header.height;
+	for (uint32_t i = 0; i < numLevels; i++) {
+		uint64_t bytes = w * h * 4;
+		if (header.offsets[i] < sizeof(TextureCacheHeader) || header.offsets[i] > fileSize ||
+			bytes > fileSize - header.offsets[i]) return false;
+		w = max(w / 2, uint64_t(1));
+		h = max(h / 2, uint64_t(1));
+	}
+	return true;
+}
+
+// build:  decode, convert to RGBA, write level 0 and each halving down
+// to 1x1
+//
+bool TextureCache::build(const string & source, float * decodeMs) {
+	string path = cachePath(source);
+	{
+		ifstream in(path.c_str(), ios::binary | ios::ate);
+		uint64_t size = in.is_open() ? uint64_t(in.tellg()) : 0;
+		in.seekg(0);
+		TextureCacheHeader header;
+		if (in.read((char *) &header, sizeof(header)) && headerCurrent(header, source) && layoutValid(header, size)) {
+			if (decodeMs) *decodeMs = 0;
+			return true;
+		}
+	}
+
+	uint64_t t1 = ofGetElapsedTimeMicros();
+	ofPixels pixels;
+	if (!ofLoadImage(pixels, source)) {
+		ofLogError("TextureCache") << "can't decode " << source;
+		return false;
+	}
+	pixels.setImageType(OF_IMAGE_COLOR_ALPHA);
+
+	TextureCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, cacheMagic, 4);
+	header.version = cacheVersion;
+	header.width = pixels.getWidth();
+	header.height = pixels.getHeight();
+	sourceStamp(ofToDataPath(source, true), header.sourceSize, header.sourceTime);
+
+	ofDirectory::createDirectory(ofToDataPath(cacheDir, true), false, true);
+	string tmpPath = path + ".tmp";
+	ofstream out(tmpPath.c_str(), ios::binary);
+	if (!out.is_open()) {
+		ofLogError("TextureCache") << "can't write " << tmpPath;
+		return false;
+	}
+	out.write((const char *) &header, sizeof(header));
+
+	int w = header.width;
+	int h = header.height;
+	const unsigned char * level = pixels.getData();
+	vector<unsigned char> current, next;
+	uint64_t offset = sizeof(header);
+	int numLevels = 0;
+	while (numLevels < TextureCacheHeader::maxLevels) {
+		size_t bytes = size_t(w) * h * 4;
+		header.offsets[numLevels++] = offset;
+		out.write((const char *) level, bytes);
+		offset += bytes;
+		if (w == 1 && h == 1) break;
+
+		int nw, nh;
+		downsample(level, w, h, next, nw, nh);
+		current.swap(next);
+		level = current.data();
+		w = nw;
+		h = nh;
+	}
+	header.numLevels = numLevels;
+	out.seekp(0);
+	out.write((const char *) &header, sizeof(header));
+	out.close();
+
+	// rename over the old file only once it is complete, so a reader
+	// never maps a half written one
+	//
+	remove(path.c_str());
+	if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+		ofLogError("TextureCache") << "can't write " << path;
+		return false;
+	}
+
+	uint64_t t2 = ofGetElapsedTimeMicros();
+	if (decodeMs) *decodeMs = (t2 - t1) / 1000.0;
+	return true;
+}
+
+// buildAll:  sources are handed out one at a time from a shared counter,
+// so a few large images don't hold up the rest
+//
+int TextureCache::buildAll(const vector<string> & sources, int numThreads) {
+	if (numThreads < 1) numThreads = max(1, int(thread::hardware_concurrency()));
+	atomic<int> next(0);
+	atomic<int> built(0);
+	mutex outputLock;
+	vector<thread> threads;
+	for (int t = 0; t < numThreads; t++) {
+		threads.push_back(thread([&] {
+			int i;
+			while ((i = next++) < int(sources.size())) {
+				float ms = 0;
+				bool ok = build(sources[i], &ms);
+				if (ok) built++;
+				lock_guard<mutex> guard(outputLock);
+				cout << (ok ? (ms > 0 ? "built  " : "cached ") : "FAILED ") << sources[i];
+				if (ms > 0) cout << "  " << ms << " ms";
+				cout << endl;
+			}
+		}));
+	}
+	for (int t = 0; t < int(threads.size()); t++) threads[t].join();
+	return built;
+}
+
+bool TextureCache::open(const string & source, CachedTexture & textureRtn) {
+	textureRtn.source = source;
+	textureRtn.file.close();
+
+	// map first - the common case is a hit
+	//
+	uint64_t t1 = ofGetElapsedTimeMicros();
+	string path = cachePath(source);
+	textureRtn.bHit = false;
+	if (textureRtn.file.open(path) && textureRtn.file.size >= sizeof(TextureCacheHeader) &&
+		headerCurrent(*(const TextureCacheHeader *) textureRtn.file.data, source) &&
+		layoutValid(*(const TextureCacheHeader *) textureRtn.file.data, textureRtn.file.size)) {
+		textureRtn.bHit = true;
+	}
+	else {
+		textureRtn.file.close();
+		if (!build(source, &textureRtn.decodeTime) || !textureRtn.file.open(path)) return false;
+
+		// the file may have been replaced again meanwhile
+		//
+		if (textureRtn.file.size < sizeof(TextureCacheHeader) ||
+			!layoutValid(*(const TextureCacheHeader *) textureRtn.file.data, textureRtn.file.size)) {
+			ofLogError("TextureCache") << "bad cache file " << path;
+			textureRtn.file.close();
+			return false;
+		}
+	}
+	uint64_t t2 = ofGetElapsedTimeMicros();
+	textureRtn.mapTime = (t2 - t1) / 1000.0 - textureRtn.decodeTime;
+
+	const TextureCacheHeader & header = *(const TextureCacheHeader *) textureRtn.file.data;
+	textureRtn.width = header.width;
+	textureRtn.height = header.height;
+	textureRtn.numLevels = header.numLevels;
+	textureRtn.bytes = textureRtn.file.size - sizeof(TextureCacheHeader);
+	for (uint32_t i = 0; i < header.numLevels; i++) {
+		textureRtn.levels[i] = textureRtn.file.data + header.offsets[i];
+	}
+	return true;
+}
+
+void TextureCache::upload(CachedTexture & cached, ofTexture & texture) {
+	uint64_t t1 = ofGetElapsedTimeMicros();
+	int w = cached.width;
+	int h = cached.height;
+	texture.allocate(w, h, GL_RGBA8, false);
+	texture.loadData(cached.levels[0], w, h, GL_RGBA);
+
+	texture.bind();
+	GLenum target = texture.getTextureData().textureTarget;
+	for (int i = 1; i < cached.numLevels; i++) {
+		w = max(1, w / 2);
+		h = max(1, h / 2);
+		glTexImage2D(target, i, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, cached.levels[i]);
+	}
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, cached.numLevels - 1);
+	texture.unbind();
+	texture.setTextureMinMagFilter(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
+
+	cached.file.close();
+	uint64_t t2 = ofGetElapsedTimeMicros();
+	cached.uploadTime = (t2 - t1) / 1000.0;
+}
+
+bool TextureCache::load(const string & source, ofTexture & texture) {
+	CachedTexture cached;
+	if (!open(source, cached)) return false;
+	upload(cached, texture);
+	report(cached);
+	return true;
+}
+
+// report:  one line per texture - size, levels, the memory the levels
+// take on the GPU (the mapping is gone after the upload) and where the
+// time went
+//
+void TextureCache::report(const CachedTexture & cached) {
+	ofLogNotice("TextureCache") << cached.source << ": " << cached.width << "x" << cached.height << ", "
+		<< cached.numLevels << " levels, " << cached.bytes / 1024 << " KB, "
+		<< (cached.bHit ? "cache hit" : "cache miss") << ", decode " << cached.decodeTime << " ms, map "
+		<< cached.mapTime << " ms, upload " << cached.uploadTime << " ms";
+}
+
+// findImages:  jpg and png files under dir (relative to data), recursively
+//
+vector<string> TextureCache::findImages(const string & dir) {
+	vector<string> images;
+	ofDirectory listing(ofToDataPath(dir, true));
+	listing.listDir();
+	for (int i = 0; i < int(listing.size()); i++) {
+		string name = listing.getName(i);
+		string path = dir + "/" + name;
+		if (listing.getFile(i).isDirectory()) {
+			vector<string> sub = findImages(path);
+			images.insert(images.end(), sub.begin(), sub.end());
+			continue;
+		}
+		string ext = ofToLower(ofFilePath::getFileExt(name));
+		if (ext == "jpg" || ext == "jpeg" || ext == "png") images.push_back(path);
+	}
+	return images;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  TextureCache
+//
+//  Description:
+//  Decoded textures cached on disk, ready to upload.  A cache
+//  file holds a header and the full mip chain as raw RGBA8,
+//  level 0 first; it is memory mapped on load, so a hit costs
+//  no decoding and no copy before the upload.  A miss (no
+//  cache file, or the source changed since) decodes the JPG /
+//  PNG and writes the file.  buildAll() fills the cache for a
+//  list of images in parallel, see --build-texture-cache in
+//  main.cpp.
+//
+//  Cache files live in data/cache, named after the source path.
+//
+//--------------------------------------------------------------
+
+#include "ofMain.h"
+
+// read only memory mapping of a whole file (Win32 or POSIX)
+//
+class MappedFile {
+public:
+	MappedFile() { }
+	~MappedFile() { close(); }
+
+	bool open(const string & path);
+	void close();
+
+	const unsigned char * data = NULL;
+	size_t size = 0;
+
+private:
+	MappedFile(const MappedFile &);
+	MappedFile & operator=(const MappedFile &);
+#ifdef _WIN32
+	void * file = NULL;
+	void * mapping = NULL;
+#else
+	int fd = -1;
+#endif
+};
+
+class TextureCacheHeader {
+public:
+	static const int maxLevels = 16;
+
+	char magic[4];
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t numLevels;
+	uint32_t pad;
+	uint64_t sourceSize;        // source file size and modification
+	uint64_t sourceTime;        // time, a mismatch means stale
+	uint64_t offsets[maxLevels];
+};
+
+class CachedTexture {
+public:
+	string source;
+	int width = 0;
+	int height = 0;
+	int numLevels = 0;
+	const unsigned char * levels[TextureCacheHeader::maxLevels];
+	size_t bytes = 0;           // all levels, as uploaded
+	bool bHit = false;
+
+	// ms - decode and cache write on a miss, map, upload
+	//
+	float decodeTime = 0;
+	float mapTime = 0;
+	float uploadTime = 0;
+
+	MappedFile file;
+};
+
+class TextureCache {
+public:
+	string cacheDir = "cache";
+
+	// decode source and write its cache file, unless it is up to date;
+	// safe to call from any thread
+	//
+	bool build(const string & source, float * decodeMs = NULL);
+
+	// build the cache files of all sources, numThreads at a time
+	// (0 = one per core)
+	//
+	int buildAll(const vector<string> & sources, int numThreads = 0);
+
+	// map the cache file of source, building it first on a miss; any
+	// thread
+	//
+	bool open(const string & source, CachedTexture & textureRtn);
+
+	// upload every level to a mipmapped GL_TEXTURE_2D and unmap the
+	// file; main thread
+	//
+	void upload(CachedTexture & cached, ofTexture & texture);
+
+	// open and upload in one go
+	//
+	bool load(const string & source, ofTexture & texture);
+
+	static void report(const CachedTexture & cached);
+	static vector<string> findImages(const string & dir);
+
+	string cachePath(const string & source) const;
+
+private:
+	static bool sourceStamp(const string & path, uint64_t & size, uint64_t & time);
+	static bool headerCurrent(const TextureCacheHeader & header, const string & source);
+	static bool layoutValid(const TextureCacheHeader & header, uint64_t fileSize);
+};
@@ -4,7 +4,7 @@
 //  Base class for any object that needs a transform.
 //
 TransformObject::TransformObject() {
-	position = ofVec3f(ofGetWindowWidth() / 2, ofGetWindowHeight() / 2, 0);
+	position = ofVec3f(0, 0, 0);
 	scale = ofVec3f(10, 10, 10);
 	rotation = 0;
 }
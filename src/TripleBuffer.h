@@ -0,0 +1,51 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  TripleBuffer
+//
+//  Description:
+//  Lock-free hand off of the latest value from one writer
+//  thread to one reader thread.  The writer fills back() and
+//  publish()es it; the reader calls update() and reads
+//  front().  Neither side ever waits for the other:  the
+//  writer always has a slot to fill, and the reader keeps its
+//  slot until it asks for a newer one.  Values the reader
+//  doesn't get to in time are skipped, never queued.
+//
+//  Slots are reused, so the writer must assign every field of
+//  back() (vectors keep their capacity, so a steady state
+//  publish doesn't allocate).
+//
+//--------------------------------------------------------------
+
+#include <atomic>
+
+template <class T>
+class TripleBuffer {
+public:
+	// writer
+	//
+	T & back() { return slots[backIndex]; }
+	void publish() {
+		backIndex = middle.exchange(backIndex | freshBit, std::memory_order_acq_rel) & indexMask;
+	}
+
+	// reader:  true if a newer value was published since the last call
+	//
+	bool update() {
+		if (!(middle.load(std::memory_order_relaxed) & freshBit)) return false;
+		frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & indexMask;
+		return true;
+	}
+	const T & front() const { return slots[frontIndex]; }
+
+private:
+	static const int indexMask = 3;
+	static const int freshBit = 4;
+
+	T slots[3];
+	int backIndex = 0;                  // writer only
+	int frontIndex = 1;                 // reader only
+	std::atomic<int> middle { 2 };      // slot index, | freshBit once published
+};
@@ -35,3 +35,96 @@ bool Box::intersect(const Ray &r, float t0, float t1) const {
     tmax = tzmax;
   return ( (tmin < t1) && (tmax > t0) );
 }
+
+bool Box::intersect(const Ray &r, float t0, float t1, float &tRtn) const {
+  float tmin, tmax, tymin, tymax, tzmin, tzmax;
+
+  tmin = (parameters[r.sign[0]].x() - r.origin.x()) * r.inv_direction.x();
+  tmax = (parameters[1-r.sign[0]].x() - r.origin.x()) * r.inv_direction.x();
+  tymin = (parameters[r.sign[1]].y() - r.origin.y()) * r.inv_direction.y();
+  tymax = (parameters[1-r.sign[1]].y() - r.origin.y()) * r.inv_direction.y();
+  if ( (tmin > tymax) || (tymin > tmax) ) 
+    return false;
+  if (tymin > tmin)
+    tmin = tymin;
+  if (tymax < tmax)
+    tmax = tymax;
+  tzmin = (parameters[r.sign[2]].z() - r.origin.z()) * r.inv_direction.z();
+  tzmax = (parameters[1-r.sign[2]].z() - r.origin.z()) * r.inv_direction.z();
+  if ( (tmin > tzmax) || (tzmin > tmax) ) 
+    return false;
+  if (tzmin > tmin)
+    tmin = tzmin;
+  if (tzmax < tmax)
+    tmax = tzmax;
+  tRtn = (tmin > t0) ? tmin : t0;
+  return ( (tmin < t1) && (tmax > t0) );
+}
+
+OBB OBB::fromBox(const Box &local, float deg, const Vector3 &position) {
+  float a = deg * 3.14159265f / 180;
+  float c = cos(a);
+  float s = sin(a);
+
+  // columns of the rotation about y
+  Vector3 x(c, 0, -s);
+  Vector3 y(0, 1, 0);
+  Vector3 z(s, 0, c);
+
+  Vector3 mid = local.center();
+  Vector3 center = position + x * mid.x() + y * mid.y() + z * mid.z();
+  return OBB(center, x, y, z, (local.max() - local.min()) / 2);
+}
+
+Box OBB::bounds() const {
+  float e[3];
+  for (int i = 0; i < 3; i++) {
+    e[i] = fabs(axis[0][i]) * halfExtents[0] + fabs(axis[1][i]) * halfExtents[1] +
+      fabs(axis[2][i]) * halfExtents[2];
+  }
+  Vector3 extent(e[0], e[1], e[2]);
+  return Box(center - extent, center + extent);
+}
+
+bool OBB::overlap(const Box &box) const {
+  const float epsilon = 1e-6f;
+  Vector3 a = (box.max() - box.min()) / 2;
+  Vector3 t = center - box.center();
+
+  // r[i][j] = box axis i . obb axis j, the box axes being x, y, z
+  float r[3][3], absR[3][3];
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      r[i][j] = axis[j][i];
+      absR[i][j] = fabs(r[i][j]) + epsilon;
+    }
+  }
+  const Vector3 &b = halfExtents;
+  float ra, rb;
+
+  // box face normals (the AABB test against bounds())
+  for (int i = 0; i < 3; i++) {
+    ra = a[i];
+    rb = b[0] * absR[i][0] + b[1] * absR[i][1] + b[2] * absR[i][2];
+    if (fabs(t[i]) > ra + rb) return false;
+  }
+
+  // obb axes
+  for (int j = 0; j < 3; j++) {
+    ra = a[0] * absR[0][j] + a[1] * absR[1][j] + a[2] * absR[2][j];
+    rb = b[j];
+    if (fabs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) > ra + rb) return false;
+  }
+
+  // box axis i x obb axis j
+  for (int i = 0; i < 3; i++) {
+    int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+    for (int j = 0; j < 3; j++) {
+      int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+      ra = a[i1] * absR[i2][j] + a[i2] * absR[i1][j];
+      rb = b[j1] * absR[i][j2] + b[j2] * absR[i][j1];
+      if (fabs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) > ra + rb) return false;
+    }
+  }
+  return true;
+}
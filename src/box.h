@@ -25,27 +25,27 @@ class Box {
     }
     // (t0, t1) is the interval for valid hits
     bool intersect(const Ray &, float t0, float t1) const;
+    // same, and returns the entry distance along the ray in tRtn
+    bool intersect(const Ray &, float t0, float t1, float &tRtn) const;
 
     // corners
     Vector3 parameters[2];
 
-	Vector3 min() { return parameters[0]; }
-	Vector3 max() { return parameters[1]; }
-	const bool inside(const Vector3 &p) {
+	Vector3 min() const { return parameters[0]; }
+	Vector3 max() const { return parameters[1]; }
+	bool inside(const Vector3 &p) const {
 		return ((p.x() >= parameters[0].x() && p.x() <= parameters[1].x()) &&
 		     	(p.y() >= parameters[0].y() && p.y() <= parameters[1].y()) &&
 			    (p.z() >= parameters[0].z() && p.z() <= parameters[1].z()));
 	}
-	const bool inside(Vector3 *points, int size) {
-		bool allInside = true;
+	bool inside(const Vector3 *points, int size) const {
 		for (int i = 0; i < size; i++) {
-			if (!inside(points[i])) allInside = false;
-			break;
+			if (!inside(points[i])) return false;
 		}
-		return allInside;
+		return true;
 	}
 
-	 bool overlap(const Box &box) {
+	 bool overlap(const Box &box) const {
 		 if ((parameters[0].x() <= box.parameters[1].x() && parameters[1].x() >= box.parameters[0].x()) &&
 			 (parameters[0].y() <= box.parameters[1].y() && parameters[1].y() >= box.parameters[0].y()) &&
 			 (parameters[0].z() <= box.parameters[1].z() && parameters[1].z() >= box.parameters[0].z()))
@@ -54,9 +54,66 @@ class Box {
 			 return false;
 	}
 
-	Vector3 center() {
+	Vector3 center() const {
 		return ((max() - min()) / 2 + min());
 	}
+
+	// squared distance from p to the box (0 if p is inside)
+	//
+	float distance2(const Vector3 &p) const {
+		float d = 0;
+		for (int i = 0; i < 3; i++) {
+			if (p[i] < parameters[0][i]) d += (parameters[0][i] - p[i]) * (parameters[0][i] - p[i]);
+			else if (p[i] > parameters[1][i]) d += (p[i] - parameters[1][i]) * (p[i] - parameters[1][i]);
+		}
+		return d;
+	}
+};
+
+/*
+ * Oriented bounding box:  center, three orthonormal axes and the half
+ * extents along them.  overlap() is the separating axis test against an
+ * axis-aligned Box (the 3 Box face normals, the 3 OBB axes and their 9
+ * cross products), as described in:
+ *
+ *      Christer Ericson, "Real-Time Collision Detection", 4.4.1
+ *
+ */
+
+class OBB {
+  public:
+	OBB() { }
+	OBB(const Vector3 &center, const Vector3 &axisX, const Vector3 &axisY, const Vector3 &axisZ,
+		const Vector3 &halfExtents) {
+		this->center = center;
+		axis[0] = axisX;
+		axis[1] = axisY;
+		axis[2] = axisZ;
+		this->halfExtents = halfExtents;
+	}
+
+	// a Box in model space, rotated deg about y (as ofNode::setRotation
+	// does) and then moved to position
+	//
+	static OBB fromBox(const Box &local, float deg, const Vector3 &position);
+
+	Vector3 center;
+	Vector3 axis[3];
+	Vector3 halfExtents;
+
+	// axis-aligned box around this one
+	//
+	Box bounds() const;
+
+	bool overlap(const Box &box) const;
+
+	bool inside(const Vector3 &p) const {
+		Vector3 d = p - center;
+		for (int i = 0; i < 3; i++) {
+			if (fabs(d * axis[i]) > halfExtents[i]) return false;
+		}
+		return true;
+	}
 };
 
 #endif // _BOX_H_
@@ -1,8 +1,40 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "Benchmark.h"
+#include "TextureCache.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char *argv[]){
+
+	// headless benchmarks:  lander --bench [name prefix]
+	//
+	if (argc > 1 && string(argv[1]) == "--bench") {
+		return runBenchmarks(argc > 2 ? argv[2] : "");
+	}
+
+	// concurrent octree/BVH query check:  lander --stress [threads]
+	//
+	if (argc > 1 && string(argv[1]) == "--stress") {
+		return runStress(argc > 2 ? atoi(argv[2]) : 0);
+	}
+
+	// octree/BVH results against brute force:  lander --conformance
+	//
+	if (argc > 1 && string(argv[1]) == "--conformance") {
+		return runConformance();
+	}
+
+	// decode every texture under data/geo (or the given directory under
+	// data) into the texture cache:  lander --build-texture-cache [dir]
+	//
+	if (argc > 1 && string(argv[1]) == "--build-texture-cache") {
+		TextureCache cache;
+		vector<string> images = TextureCache::findImages(argc > 2 ? argv[2] : "geo");
+		int built = cache.buildAll(images);
+		cout << built << " of " << images.size() << " textures cached in data/" << cache.cacheDir << endl;
+		return built == int(images.size()) ? 0 : 1;
+	}
+
 	ofSetupOpenGL(1920, 1080,OF_WINDOW);			// <-------- setup the GL context
 
 	// this kicks off the running of my app
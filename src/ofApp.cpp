@@ -11,14 +11,16 @@
 
 #include "ofApp.h"
 #include "Util.h"
+#include "Profiler.h"
 
 //--------------------------------------------------------------
 //
 //  Setup
 // 
 //  Description: 
-//  Loads cameras, lighting, land, lander, forces, and
-//  emitters.
+//  Loads cameras, lighting, forces, and emitters, and starts
+//  loading land, lander, background and sounds in the
+//  background (see AssetLoader).
 // 
 //--------------------------------------------------------------
 void ofApp::setup(){
@@ -26,30 +28,82 @@ void ofApp::setup(){
 	bDisplayPoints = false;
 	bAltKeyDown = false;
 	bCtrlKeyDown = false;
-	bLanderLoaded = true;
+	bLanderLoaded = false;
 	bTerrainSelected = true;
 
 	// Loads cameras and lighting.
 	//
 	camSetup();
 	lightingSetup();
-	soundSetup();
 
 	ofSetVerticalSync(true);
 	ofEnableSmoothing();
 	ofEnableDepthTest();
 
-	// Load land, lander, and background image.
+	// Load land, lander, background image and sounds while the loading
+	// screen shows.  Models load on the main thread (they create GL
+	// objects), sounds on the audio thread, the image is mapped from the
+	// texture cache (decoded on a miss) and the octree built on worker
+	// threads.
 	//
-	land.loadModel("geo/moon-houdini.obj");
-	land.setScaleNormalization(false);
-
-	lander.loadModel("geo/lander.obj");
-	lander.setScaleNormalization(false);
-	landerPos = lander.getPosition();
-	landerRot = lander.getRotationAngle(0);
-
-	background.loadImage("geo/stars.jpg");
+	int terrainModel = loader.add("terrain model", 2, nullptr, [this] {
+		land.loadModel("geo/moon-houdini.obj");
+		land.setScaleNormalization(false);
+		terrainMesh = land.getMesh(0);
+	});
+	loader.add("lander model", 1, nullptr, [this] {
+		lander.loadModel("geo/lander.obj");
+		lander.setScaleNormalization(false);
+		landerPos = lander.getPosition();
+		landerRot = lander.getRotationAngle(0);
+		landerSceneMin = lander.getSceneMin();
+		landerSceneMax = lander.getSceneMax();
+
+		// Bounds and convex hull of each sub-mesh, for the narrow phase.
+		// They're in the frame of the scene bounds the broad phase box is
+		// made from; a sub-mesh outside them (a node transform the raw
+		// vertices don't carry) would collide where the box never looks.
+		//
+		bboxList.clear();
+		landerHulls.clear();
+		int hullVertices = 0;
+		Box scene(Vector3(landerSceneMin.x, landerSceneMin.y, landerSceneMin.z),
+			Vector3(landerSceneMax.x, landerSceneMax.y, landerSceneMax.z));
+		for (int i = 0; i < lander.getNumMeshes(); i++) {
+			ofMesh mesh = lander.getMesh(i);
+			bboxList.push_back(Octree::meshBounds(mesh));
+			if (!scene.inside(bboxList.back().min()) || !scene.inside(bboxList.back().max())) {
+				ofLogWarning("Lander") << "sub-mesh " << i << " lies outside the model's scene bounds";
+			}
+			landerHulls.push_back(ConvexHull());
+			landerHulls.back().build(mesh);
+			hullVertices += landerHulls.back().vertices.size();
+		}
+		ofLogNotice("Lander") << landerHulls.size() << " hulls, " << hullVertices << " hull vertices";
+		bLanderLoaded = true;
+	});
+	loader.add("background", 1, [this] {
+		textureCache.open("geo/stars.jpg", backgroundCache);
+	}, [this] {
+		if (backgroundCache.numLevels > 0) {
+			textureCache.upload(backgroundCache, background);
+			TextureCache::report(backgroundCache);
+		}
+	});
+	loader.add("octree", 4, [this] {
+		buildTerrain();
+	}, [this] {
+		if (land.hasTextures()) {
+			terrainChunks.texture = land.getTextureForMesh(0);
+			terrainChunks.bTexture = true;
+		}
+		terrainMesh.clear();
+	}, terrainModel);
+	loader.add("sounds", 1, nullptr, [this] {
+		soundSetup();
+	});
+	loader.start();
+	jobs.start();
 
 	// Slider values. Doesn't actually display; it's just to easily organize all the values.
 	//
@@ -75,9 +129,23 @@ void ofApp::setup(){
 	gui.add(planeMaterialSpecularBlue.setup("Plane Blue Specular Color", 1, 0.00, 10));
 	bHide = true;
 
-	// Create Octree for testing.
+	// HUD.  The tips and help never change; the fields are drawn again
+	// only when the value they show does (see draw()).
 	//
-	octree.create(land.getMesh(0), 10);
+	hudVelocity = hud.addField(1 / 2.2, 0, 0, 20);
+	hudFuel = hud.addField(1 / 2.2, 0, 0, 40);
+	hudAltitude = hud.addField(1 / 2.2, 0, 0, 60);
+	hudSimulation = hud.addField(1 / 2.2, 0, 0, 80);
+	hudSimulationOff = hud.addField(1 / 2.4, 0, 0.5, 0);
+	hudWon = hud.addField(1 / 2.4, 0, 0.5, 0);
+	hudDied = hud.addField(1 / 2.4, 0, 0.5, 0);
+	hud.addStatic("Can mouse drag in freecam while simulation is off", 1 / 2.4, 0, 0, 100);
+	hud.addStatic("and if the free cam is locked.", 1 / 2.2, 0, 0, 120);
+	const char *tips[] = { "Tips:", "WASD to move", "Spacebar to move up", "Rotate lander with Q or E",
+		"1 for follow cam", "2 for onboard cam", "3 for tracking cam", "4 for free cam",
+		"C to lock cam during free cam", "X to see altitude", "Land on the landing zone to win",
+		"O for profiler, L to dump profile" };
+	for (int i = 0; i < 12; i++) hud.addStatic(tips[i], 1, -300, 0, 20 + i * 20);
 
 	// Load the landing area.
 	//
@@ -88,7 +156,6 @@ void ofApp::setup(){
 	turbForce = new TurbulenceForce(ofVec3f(minTurbulence->x, minTurbulence->y, minTurbulence->z),
 		ofVec3f(maxTurbulence->x, maxTurbulence->y, maxTurbulence->z));
 	gravityForce = new GravityForce(ofVec3f(0, -gravity, 0));
-	dirForce = new DirectionalForce(ofVec3f(sideForce, upForce, frontForce), angularForce);
 
 	emitter.sys->addForce(turbForce);
 	emitter.sys->addForce(gravityForce);
@@ -100,22 +167,70 @@ void ofApp::setup(){
 
 	emitter2.setVelocity(ofVec3f(0, 0, 0));
 	emitter2.setOneShot(true);
-	emitter2.setEmitterType(RadialEmitter);
 	emitter2.setGroupSize(500);
 
-	moveEmitter.sys->addForce(turbForce);
-	moveEmitter.sys->addForce(gravityForce);
-	moveEmitter.sys->addForce(dirForce);
-	moveEmitter.radius = 0;
-	moveEmitter.setPosition(ofVec3f(0, 100, 100));
-	moveEmitter.setVelocity(ofVec3f(0, -10, 0));
-	moveEmitter.setLifespan(-1);
-	moveEmitter.setRate(0);
-	moveEmitter.setParticleRadius(0);
-	moveEmitter.spawn(0);
-	moveEmitter.start();
+	// Load the lander body.
+	//
+	landerBody.reset(glm::vec3(0, 100, 100));
+	landerBody.velocity = glm::vec3(0, -10, 0);
 
 	emitter.start();
+
+	// One cap for both emitters.  The explosion comes first and has half
+	// the cap to itself; the exhaust has a quarter and is the first to
+	// thin out when frames run long.
+	//
+	particleBudget.add(&emitter2, 2, 0.5);
+	particleBudget.add(&emitter, 1, 0.25);
+}
+
+//--------------------------------------------------------------
+//
+//  Build Terrain
+// 
+//  Description: 
+//  Builds the octree, the terrain chunks and the heightfield
+//  from the terrain mesh.  Runs on a loader worker thread.
+// 
+//--------------------------------------------------------------
+void ofApp::buildTerrain() {
+	// Create Octree for testing. Lean mode - only the leaves keep point
+	// lists since collision only ever asks for leaf boxes.  Nodes split
+	// until they hold a single point; 20 levels is only a safety cap and
+	// minExtent stops coincident vertices from splitting forever.
+	//
+	octree.bLean = true;
+	octree.maxLeafPoints = 1;
+	octree.minExtent = 0.05;
+	octree.create(terrainMesh, 20);
+	ofLogNotice("Octree") << "depth " << octree.report.depth << ", " << octree.report.numNodes << " nodes, "
+		<< octree.report.numLeaves << " leaves, " << octree.report.avgLeafPoints << " avg points per leaf, "
+		<< octree.report.buildTime << " ms";
+	ofLogNotice("Octree") << octree.memoryUsage() / 1024 << " KB, "
+		<< octree.bytesPerVertex() << " bytes per vertex";
+
+	// Split the terrain into chunks along the octree cells of level 3
+	// so draw() only submits the chunks in the camera's view, each at
+	// a level of detail that fits its distance.  The VBOs upload on
+	// the first draw, on the main thread.
+	//
+	terrainChunks.build(terrainMesh, octree, 3);
+	ofLogNotice("TerrainChunks") << terrainChunks.chunks.size() << " chunks, " << terrainChunks.numLods << " levels of detail, "
+		<< terrainChunks.buildTime << " ms";
+
+	// Heightfield for altitude and for skipping the octree query while
+	// the lander is clear of the ground.  Cached next to the model; a
+	// 512 grid over the moon is well under a meter per cell.
+	//
+	if (heightfield.load("geo/moon-houdini.obj")) {
+		ofLogNotice("Heightfield") << heightfield.width << " x " << heightfield.depth << " from cache";
+	}
+	else {
+		heightfield.build(terrainMesh, 512);
+		heightfield.save("geo/moon-houdini.obj");
+		ofLogNotice("Heightfield") << heightfield.width << " x " << heightfield.depth << ", "
+			<< heightfield.buildTime << " ms";
+	}
 }
 
 //--------------------------------------------------------------
@@ -182,21 +297,17 @@ void ofApp::lightingSetup() {
 }
 //--------------------------------------------------------------
 void ofApp::soundSetup() {
-	thrusterSound.load("sounds/thruster.wav"); //can be mp3 or wav
-	thrusterSound.setLoop(false); //sets loop, set to false for stuff like gun shots
-	thrusterSound.setVolume(0.3f); //sets volume to 50% of maximum, 0.0 is silent and 1.0 is full
-
-	landerDead.load("sounds/dead.wav"); //can be mp3 or wav
-	landerDead.setLoop(false); //sets loop, set to false for stuff like gun shots
-	landerDead.setVolume(0.5f); //sets volume to 50% of maximum, 0.0 is silent and 1.0 is full
-
-	winSound.load("sounds/win.wav"); //can be mp3 or wav
-	winSound.setLoop(false); //sets loop, set to false for stuff like gun shots
-	winSound.setVolume(0.5f); //sets volume to 50% of maximum, 0.0 is silent and 1.0 is full
-
-	backgroundSound.load("sounds/wind.mp3"); //can be mp3 or wav
-	backgroundSound.setLoop(true); //sets loop, set to false for stuff like gun shots
-	backgroundSound.setVolume(0.3f); //sets volume to 50% of maximum, 0.0 is silent and 1.0 is full
+	// The wind is a long track, so it's streamed from disk; the effects
+	// are short and loaded whole.  Two voices for the crash so a quick
+	// second crash doesn't cut the first.  Loading happens on the audio
+	// thread.
+	//
+	thrusterSound = audio.addEffect("sounds/thruster.wav", 0.3f);
+	landerDead = audio.addEffect("sounds/dead.wav", 0.5f, 2);
+	winSound = audio.addEffect("sounds/win.wav", 0.5f);
+	backgroundSound = audio.addStream("sounds/wind.mp3", 0.3f);
+	audio.start();
+	audio.hold(backgroundSound);
 }
 
 //--------------------------------------------------------------
@@ -204,15 +315,29 @@ void ofApp::soundSetup() {
 //  Update
 // 
 //  Description: 
-//  Updates cameras, lighting, toggles on and off physics
-//  simulation. Physics simulation contains updating position,
-//  rotation, all values from setup, and collision.
+//  Updates cameras, lighting and sounds, and trades input and
+//  snapshots with the simulation, which runs on its own thread
+//  (see Simulate).
 // 
 //--------------------------------------------------------------
 void ofApp::update() {
-	// Update cameras.
+	// Heap allocations on every thread since the last frame, counted
+	// into the frame being closed.
 	//
-	updateCameras();
+	uint64_t allocs = heapAllocations();
+	PROFILE_COUNT("heap.allocs", allocs - frameAllocs);
+	frameAllocs = allocs;
+	Profiler::instance().endFrame();
+	frameStartMicros = ofGetElapsedTimeMicros();
+	PROFILE_SCOPE("update");
+	FrameArena::local().reset();
+
+	// Nothing to simulate until the assets are in.
+	//
+	if (!loader.done()) {
+		loader.update();
+		return;
+	}
 
 	// Update lights.
 	//
@@ -220,261 +345,466 @@ void ofApp::update() {
 	fillLight.setSpecularColor(ofFloatColor(fillLightSpecularRed, fillLightSpecularGreen, fillLightSpecularBlue));
 	planeMaterial.setSpecularColor(ofFloatColor(planeMaterialSpecularRed, planeMaterialSpecularGreen, planeMaterialSpecularBlue, 1.0));
 
-	if (!backgroundSound.isPlaying())
-		backgroundSound.play();
+	// The simulation runs on its own thread once everything is loaded.
+	//
+	if (!simThread.running()) {
+		simThread.start(simRate, [this](float dt) { simulate(dt); });
+	}
 
-	// If simulation, then start physics.
+	// Send this frame's input, pick up the latest step.  The particle
+	// budget gets the time the last frame worked, not the time between
+	// frames:  with vertical sync on that never drops under the display's
+	// refresh interval, so the budget could never tell it had headroom.
 	//
+	input.simulation = simulationToggle;
+	input.frameMs = renderWorkMs;
+	inputs.back() = input;
+	inputs.publish();
+	snapshots.update();
+	const SimSnapshot & sim = snapshots.front();
+
 	if (simulationToggle) {
-		// Upon a new game, reset all values.
-		//
-		if (newGame) {
-			moveEmitter.sys->particles.at(0).position = glm::vec3(0, 100, 100);
-			moveEmitter.sys->particles.at(0).rotation = 0;
-			fuel = 12000;
-			newGame = false;
+		lander.setPosition(sim.landerPosition.x, sim.landerPosition.y, sim.landerPosition.z);
+		lander.setRotation(1, sim.landerRotation, 0, 1, 0);
+		bLanderSelected = true;
+	}
+	{
+		PROFILE_SCOPE("updateCameras");
+		updateCameras();
+	}
+	updateAudio();
+}
+
+//--------------------------------------------------------------
+//
+//  Simulate
+//
+//  Description:
+//  One fixed step of the simulation, on the sim thread.  Takes
+//  the latest input from the render thread, runs the step as a
+//  graph of jobs and publishes a snapshot for draw().
+//
+//--------------------------------------------------------------
+void ofApp::simulate(float dt) {
+	PROFILE_SCOPE("sim.step");
+	uint64_t stepStart = ofGetElapsedTimeMicros();
+	FrameArena::local().reset();
+	inputs.update();
+	simInput = inputs.front();
+
+	// Each key release cuts the thrusters, as keyReleased() used to.
+	//
+	if (simInput.releases != releasesSeen) {
+		releasesSeen = simInput.releases;
+		thrusterIsOn = false;
+		upForce = 0.0;
+		frontForce = 0.0;
+		sideForce = 0.0;
+		angularForce = 0.0;
+	}
+
+	// Set up this step's forces and emitters, then run the step's jobs:
+	// the lander and the two exhaust emitters update in parallel, the
+	// controls, the collision query and the narrow phase follow the
+	// lander, and the collision response waits for both emitters too.
+	// A crash resets emitter2's forces, which emitter shares (their
+	// applied flags), so it can't run while either emitter updates.
+	//
+	if (simInput.simulation) {
+		prepareFrame();
+
+		int landerJob = jobs.add("lander", [this, dt] { landerBody.integrate(dt); });
+		int emitterJob = jobs.add("emitter.update", [this, dt] { emitter.update(dt); });
+		int emitter2Job = jobs.add("emitter2.update", [this, dt] { emitter2.update(dt); });
+		int controlsJob = jobs.add("controls", [this] { updateControls(); }, { landerJob });
+		int queryJob = jobs.add("terrain.boxQuery", [this] { queryTerrain(); }, { controlsJob });
+		int narrowJob = jobs.add("terrain.narrowPhase", [this] { narrowPhase(); }, { queryJob });
+		jobs.add("collision", [this] { collisionResponse(); }, { narrowJob, emitterJob, emitter2Job });
+		{
+			PROFILE_SCOPE("jobs");
+			jobs.run();
 		}
+	}
+	publishSnapshot();
+	simStepMs = (ofGetElapsedTimeMicros() - stepStart) / 1000.0;
+}
 
-		// Update position, rotation, and emitters.
-		//
-		dirForce->set(ofVec3f(sideForce, upForce, frontForce) + heading(), angularForce);
-
-		lander.setPosition(moveEmitter.sys->particles.at(0).position.x,
-			moveEmitter.sys->particles.at(0).position.y,
-			moveEmitter.sys->particles.at(0).position.z);
-		lander.setRotation(1, moveEmitter.sys->particles.at(0).rotation, 0, 1, 0);
-
-		emitter.setPosition(ofVec3f(moveEmitter.sys->particles.at(0).position.x,
-			moveEmitter.sys->particles.at(0).position.y,
-			moveEmitter.sys->particles.at(0).position.z));
-		emitter.setVelocity(ofVec3f(velocitySlide));
-
-		moveEmitter.setLifespan(-1);
-		moveEmitter.setRate(0);
-		moveEmitter.setParticleRadius(0);
-		moveEmitter.spawn(0);
-		moveEmitter.update();
-
-		if (thrusterIsOn) {
-			emitter.setLifespan(float(lifespan));
-			emitter.setRate(float(rate));
-			emitter.setParticleRadius(float(radius));
-		}
-		else if (!thrusterIsOn) {
-			emitter.setLifespan(0);
-			emitter.setRate(0);
-			emitter.setParticleRadius(0);
-		}
-		emitter.update();
-
-		if (!collide || !died || !youWon)
-			turbForce = new TurbulenceForce(ofVec3f(minTurbulence->x, minTurbulence->y, minTurbulence->z),
-				ofVec3f(maxTurbulence->x, maxTurbulence->y, maxTurbulence->z));
-		else if (collide || died || youWon)
-			turbForce = new TurbulenceForce(ofVec3f(0, 0, 0), ofVec3f(0, 0, 0));
-
-		if (!collide || !died || !youWon)
-			gravityForce = new GravityForce(ofVec3f(0, -gravity, 0));
-		else if (collide || died || youWon)
-			gravityForce = new GravityForce(ofVec3f(0, 0, 0));
-
-		radialForce->set(radialForceVal, radialHeightVal);
-		emitter2.setPosition(ofVec3f(moveEmitter.sys->particles.at(0).position.x,
-			moveEmitter.sys->particles.at(0).position.y,
-			moveEmitter.sys->particles.at(0).position.z));
-		emitter2.setLifespan(lifespan);
-		emitter2.setVelocity(ofVec3f(100, 100, 100));
-		emitter2.setRate(rate);
-		emitter2.setParticleRadius(radius);
-
-		emitter2.update();
+//--------------------------------------------------------------
+// publishSnapshot:  copy what draw() needs out of the sim state
+//
+void ofApp::publishSnapshot() {
+	SimSnapshot & snap = snapshots.back();
+	snap.step = simThread.steps + 1;
+	snap.landerPosition = landerBody.position;
+	snap.landerRotation = landerBody.rotation;
+	snap.landerVelocity = landerBody.velocity;
+	snap.altitude = heightfield.empty() ? landerBody.position.y :
+		heightfield.altitude(landerBody.position) + landerSceneMin.y;
+	snap.fuel = fuel;
+	snap.thrusterIsOn = thrusterIsOn;
+	snap.died = died;
+	snap.youWon = youWon;
+	snap.crashes = crashes;
+	snap.exhaust = emitter.sys->particles;
+	snap.explosion = emitter2.sys->particles;
+	snap.queryStats = terrainQueryStats;
+	snap.contacts = contacts;
+	snapshots.publish();
+}
 
-		bLanderSelected = true;
+//--------------------------------------------------------------
+// prepareFrame:  serial part of the simulation step, before the jobs.
+// Resets a new game and sets the forces and emitters from the sliders
+// and the lander's position.
+//
+void ofApp::prepareFrame() {
+	// Upon a new game, reset all values.
+	//
+	if (newGame) {
+		landerBody.reset(glm::vec3(0, 100, 100));
+		fuel = 12000;
+		newGame = false;
+	}
 
-		// If collide, then set a boolean to true. Otherwise false.
-		//
-		if (colBoxList.size() > 0) {
-			collide = true;
-		}
-		else if (colBoxList.size() == 0) {
-			collide = false;
-		}
+	// Forces on the lander for this step:  gravity, turbulence, and the
+	// thrusters from the controls.
+	//
+	landerBody.addForce(glm::vec3(0, -gravity, 0) * landerBody.mass);
+	landerBody.addForce(glm::vec3(threadRandom(minTurbulence->x, maxTurbulence->x),
+		threadRandom(minTurbulence->y, maxTurbulence->y),
+		threadRandom(minTurbulence->z, maxTurbulence->z)));
+	landerBody.addForce((glm::vec3(sideForce, upForce, frontForce) + landerBody.heading()) * landerBody.mass);
+	landerBody.addTorque(angularForce * landerBody.mass);
+
+	// Update emitters.
+	//
 
-		// Sound effect for thruster and win.
-		//
-		if (thrusterIsOn && !thrusterSound.isPlaying())
-			thrusterSound.play();
-		else if (!thrusterIsOn && thrusterSound.isPlaying())
-			thrusterSound.stop();
+	emitter.setPosition(ofVec3f(landerBody.position.x, landerBody.position.y, landerBody.position.z));
+	emitter.setVelocity(ofVec3f(velocitySlide));
 
-		if (youWon && !winSound.isPlaying())
-			winSound.play();
-		else if (!youWon && winSound.isPlaying())
-			winSound.stop();
 
-		// Movement based on keymaps. Uses forces.
-		//
-		if (keymap['W'] || keymap['w'] || keymap[OF_KEY_UP]) {
-			if (fuel > 0 && colBoxList.size() == 0) {
-				frontForce -= 0.1;
-				fuel -= 1;
-				thrusterIsOn = true;
-			}
-			else if (fuel <= 0) {
-				thrusterIsOn = false;
-			}
-			if (collide) {
-				thrusterIsOn = false;
-			}
+	if (thrusterIsOn) {
+		emitter.setLifespan(float(lifespan));
+		emitter.setRate(float(rate));
+		emitter.setParticleRadius(float(radius));
+	}
+	else if (!thrusterIsOn) {
+		emitter.setLifespan(0);
+		emitter.setRate(0);
+		emitter.setParticleRadius(0);
+	}
+
+	// The emitters' forces are updated in place; they used to be replaced
+	// by new ones every step, which leaked them and never reached the
+	// particle systems (those kept the ones from setup()).
+	//
+	if (!collide || !died || !youWon)
+		turbForce->set(ofVec3f(minTurbulence->x, minTurbulence->y, minTurbulence->z),
+			ofVec3f(maxTurbulence->x, maxTurbulence->y, maxTurbulence->z));
+	else if (collide || died || youWon)
+		turbForce->set(ofVec3f(0, 0, 0), ofVec3f(0, 0, 0));
+
+	if (!collide || !died || !youWon)
+		gravityForce->set(ofVec3f(0, -gravity, 0));
+	else if (collide || died || youWon)
+		gravityForce->set(ofVec3f(0, 0, 0));
+
+	radialForce->set(radialForceVal, radialHeightVal);
+	emitter2.setPosition(ofVec3f(landerBody.position.x, landerBody.position.y, landerBody.position.z));
+	emitter2.setLifespan(lifespan);
+	emitter2.setVelocity(ofVec3f(100, 100, 100));
+	emitter2.setRate(rate);
+	emitter2.setParticleRadius(radius);
+
+	// Spawn allowances and rate / lifespan scales for this step, against
+	// whichever thread is busier:  the render thread's last frame or the
+	// last step.
+	//
+	particleBudget.update(max(simInput.frameMs, simStepMs));
+	PROFILE_MAX("particles.total", particleBudget.total());
+	PROFILE_COUNT("particles.trimmed", particleBudget.trimmed);
+	PROFILE_MAX("particles.quality%", int(particleBudget.quality * 100));
+}
+
+//--------------------------------------------------------------
+// updateControls:  thrusters from the keys, against last step's contacts
+//
+void ofApp::updateControls() {
+	// If collide, then set a boolean to true. Otherwise false.  Exact
+	// contacts from the narrow phase, or the leaf boxes if the lander
+	// has no hulls.
+	//
+	if (landerHulls.empty()) collide = colBoxList.size() > 0;
+	else collide = contacts.size() > 0;
+
+	// Movement based on the keys held (SimInput). Uses forces.
+	//
+	if (simInput.forward) {
+		if (fuel > 0 && colBoxList.size() == 0) {
+			frontForce -= 0.1;
+			fuel -= 1;
+			thrusterIsOn = true;
 		}
-		if (keymap['A'] || keymap['a'] || keymap[OF_KEY_LEFT]) {
-			if (fuel > 0 && colBoxList.size() == 0) {
-				sideForce -= 0.1;
-				fuel -= 1;
-				thrusterIsOn = true;
-			}
-			else if (fuel <= 0) {
-				thrusterIsOn = false;
-			}
-			if (collide) {
-				thrusterIsOn = false;
-			}
+		else if (fuel <= 0) {
+			thrusterIsOn = false;
 		}
-		if (keymap['S'] || keymap['s'] || keymap[OF_KEY_DOWN]) {
-			if (fuel > 0 && colBoxList.size() == 0) {
-				frontForce += 0.1;
-				fuel -= 1;
-				thrusterIsOn = true;
-			}
-			else if (fuel <= 0) {
-				thrusterIsOn = false;
-			}
-			if (collide) {
-				thrusterIsOn = false;
-			}
+		if (collide) {
+			thrusterIsOn = false;
 		}
-		if (keymap['D'] || keymap['d'] || keymap[OF_KEY_RIGHT]) {
-			if (fuel > 0 && colBoxList.size() == 0) {
-				sideForce += 0.1;
-				fuel -= 1;
-				thrusterIsOn = true;
-			}
-			else if (fuel <= 0) {
-				thrusterIsOn = false;
-			}
-			if (collide) {
-				thrusterIsOn = false;
-			}
+	}
+	if (simInput.left) {
+		if (fuel > 0 && colBoxList.size() == 0) {
+			sideForce -= 0.1;
+			fuel -= 1;
+			thrusterIsOn = true;
 		}
-		if (keymap[' '] && !youWon && !died) {
-			if (fuel > 0) {
-				upForce += 0.3;
-				fuel -= 1;
-				thrusterIsOn = true;
-			}
-			else if (fuel <= 0) {
-				thrusterIsOn = false;
-			}
+		else if (fuel <= 0) {
+			thrusterIsOn = false;
+		}
+		if (collide) {
+			thrusterIsOn = false;
+		}
+	}
+	if (simInput.back) {
+		if (fuel > 0 && colBoxList.size() == 0) {
+			frontForce += 0.1;
+			fuel -= 1;
+			thrusterIsOn = true;
+		}
+		else if (fuel <= 0) {
+			thrusterIsOn = false;
+		}
+		if (collide) {
+			thrusterIsOn = false;
+		}
+	}
+	if (simInput.right) {
+		if (fuel > 0 && colBoxList.size() == 0) {
+			sideForce += 0.1;
+			fuel -= 1;
+			thrusterIsOn = true;
+		}
+		else if (fuel <= 0) {
+			thrusterIsOn = false;
+		}
+		if (collide) {
+			thrusterIsOn = false;
+		}
+	}
+	if (simInput.thrust && !youWon && !died) {
+		if (fuel > 0) {
+			upForce += 0.3;
+			fuel -= 1;
+			thrusterIsOn = true;
+		}
+		else if (fuel <= 0) {
+			thrusterIsOn = false;
+		}
+
+		if (collide)
+			thrusterIsOn = false;
+	}
+	if (simInput.restart && (youWon || died)) {
+		youWon = false;
+		died = false;
+		newGame = true;
+	}
+	if (simInput.rotateLeft) {
+		if (fuel > 0) {
+			angularForce += 1;
+		}
+		else if (fuel <= 0) {
 
-			if (collide)
-				thrusterIsOn = false;
 		}
-		if ((keymap['P'] && (youWon || died)) || (keymap['p'] && (youWon || died))) {
-			youWon = false;
-			died = false;
-			newGame = true;
+		if (collide)
+			landerBody.angularVelocity = 0;
+	}
+	if (simInput.rotateRight) {
+		if (fuel > 0) {
+			angularForce -= 1;
 		}
-		if (keymap['Q'] || keymap['q']) {
-			if (fuel > 0) {
-				angularForce += 1;
-			}
-			else if (fuel <= 0) {
+		else if (fuel <= 0) {
 
-			}
-			if (collide)
-				moveEmitter.sys->particles.at(0).angularVelocity = 0;
 		}
-		if (keymap['E'] || keymap['e']) {
-			if (fuel > 0) {
-				angularForce -= 1;
-			}
-			else if (fuel <= 0) {
+		if (collide)
+			landerBody.angularVelocity = 0;
+	}
+}
 
-			}
-			if (collide)
-				moveEmitter.sys->particles.at(0).angularVelocity = 0;
+//--------------------------------------------------------------
+// queryTerrain:  terrain leaves under the lander, into colBoxList.  The
+// lander's model box is turned with the body into an oriented box, so a
+// yawed lander no longer drags in the terrain under the corners of its
+// (larger) axis aligned bounds.  The bounds come from the lander body,
+// not the model, which belongs to the render thread.  While the lander
+// is above every heightfield cell under it the octree isn't asked at all.
+//
+void ofApp::queryTerrain() {
+	Box local(Vector3(landerSceneMin.x, landerSceneMin.y, landerSceneMin.z),
+		Vector3(landerSceneMax.x, landerSceneMax.y, landerSceneMax.z));
+	glm::vec3 position = landerBody.position;
+
+	landerOBB = OBB::fromBox(local, landerBody.rotation, Vector3(position.x, position.y, position.z));
+	landerBounds = landerOBB.bounds();
+
+	colBoxList.clear();
+	if (heightfield.above(landerBounds)) {
+		PROFILE_COUNT("terrain.heightfieldRejects", 1);
+		return;
+	}
+	QueryStats stats;
+	terrainIndex->boxQuery(landerOBB, colBoxList, &stats);
+	terrainQueryStats.add(stats);
+	PROFILE_COUNT("terrain.nodesVisited", stats.nodesVisited);
+	PROFILE_COUNT("terrain.boxTests", stats.boxTests);
+	PROFILE_COUNT("terrain.leaves", stats.leavesReached);
+	PROFILE_MAX("terrain.maxDepth", stats.maxDepth);
+}
+
+//--------------------------------------------------------------
+// narrowPhase:  exact contacts between the lander's hulls and the terrain
+// triangles under its OBB, into contacts.  Only runs when the broad phase
+// found leaves under the lander; each hull is moved into the world once,
+// then tested against the triangles whose bounds reach its own.
+//
+void ofApp::narrowPhase() {
+	contacts.clear();
+	if (colBoxList.empty() || landerHulls.empty()) return;
+
+	terrainTriangles.clear();
+	terrainIndex->triangleQuery(landerOBB, terrainTriangles);
+
+	glm::mat4 toWorld = landerBody.modelToWorld();
+	glm::vec3 tri[3];
+	for (int h = 0; h < int(landerHulls.size()); h++) {
+		const vector<glm::vec3> & local = landerHulls[h].vertices;
+		if (local.empty()) continue;
+		hullWorld.resize(local.size());
+		glm::vec3 min = glm::vec3(FLT_MAX), max = glm::vec3(-FLT_MAX);
+		for (int i = 0; i < int(local.size()); i++) {
+			const glm::vec3 & v = local[i];
+			hullWorld[i] = glm::vec3(toWorld * glm::vec4(v, 1));
+			min = glm::min(min, hullWorld[i]);
+			max = glm::max(max, hullWorld[i]);
 		}
+		for (int t = 0; t < int(terrainTriangles.size()); t++) {
+			terrainIndex->triangle(terrainTriangles[t], tri[0], tri[1], tri[2]);
+			glm::vec3 triMin = glm::min(tri[0], glm::min(tri[1], tri[2]));
+			glm::vec3 triMax = glm::max(tri[0], glm::max(tri[1], tri[2]));
+			if (triMin.x > max.x || triMin.y > max.y || triMin.z > max.z ||
+				triMax.x < min.x || triMax.y < min.y || triMax.z < min.z) continue;
+			Contact contact;
+			if (convexOverlap(hullWorld.data(), hullWorld.size(), tri, 3, &contact)) contacts.push_back(contact);
+		}
+	}
+	PROFILE_COUNT("narrowphase.triangles", terrainTriangles.size());
+	PROFILE_COUNT("narrowphase.contacts", contacts.size());
+}
 
-		//------------------------------------------------------------------------------------
-		// Checks for intersection so that collide can work.
-		//
-		ofVec3f min = lander.getSceneMin() + lander.getPosition();
-		ofVec3f max = lander.getSceneMax() + lander.getPosition();
+//--------------------------------------------------------------
+// belowGround:  the lander fell through the terrain (between queries, or
+// off the octree's leaves).  Off the heightfield there's no ground, so it
+// falls back to a fixed floor.
+//
+bool ofApp::belowGround() const {
+	const float margin = 2;
+	glm::vec3 position = landerBody.position;
+	if (heightfield.contains(position.x, position.z)) return heightfield.altitude(position) < -margin;
+	return position.y < -10;
+}
 
-		Box bounds = Box(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z));
+//--------------------------------------------------------------
+// collisionResponse:  crash, landing or resting on the terrain.  Runs
+// after both emitters' updates since a crash restarts emitter2 and
+// resets the forces it shares with emitter.
+//
+void ofApp::collisionResponse() {
+	const OBB & bounds = landerOBB;
 
-		colBoxList.clear();
-		octree.intersect(bounds, octree.root, colBoxList);
-		//------------------------------------------------------------------------------------
+	if ((collide && !bounds.overlap(landArea) && ((landerBody.velocity.y > 1) || (landerBody.velocity.y < -1))) ||
+		(belowGround() && ((landerBody.velocity.y > 1) || (landerBody.velocity.y < -1)))) {
+		died = true;
+		youWon = false;
+		thrusterIsOn = false;
 
-		// Everything below is for collision.
+		// Sound effect for crash landing.
 		//
-		if ((collide && !bounds.overlap(landArea) && ((moveEmitter.sys->particles.at(0).velocity.y > 1) || (moveEmitter.sys->particles.at(0).velocity.y < -1))) ||
-			(moveEmitter.sys->particles.at(0).position.y < -10 && ((moveEmitter.sys->particles.at(0).velocity.y > 1) || (moveEmitter.sys->particles.at(0).velocity.y < -1)))) {
-			died = true;
-			youWon = false;
-			thrusterIsOn = false;
+		crashes++;
+	}
 
-			// Sound effect for crash landing.
-			//
-			if (!landerDead.isPlaying())
-				landerDead.play();
-			else if (landerDead.isPlaying())
-				landerDead.stop();
-		}
+	if ((collide && !bounds.overlap(landArea) && ((landerBody.velocity.y > 1) || (landerBody.velocity.y < -1))) ||
+		(belowGround() && ((landerBody.velocity.y > 1) || (landerBody.velocity.y < -1)))) {
+		emitter2.sys->reset();
+		emitter2.start();
+		landerBody.stop();
+	}
 
-		if ((collide && !bounds.overlap(landArea) && ((moveEmitter.sys->particles.at(0).velocity.y > 1) || (moveEmitter.sys->particles.at(0).velocity.y < -1))) ||
-			(moveEmitter.sys->particles.at(0).position.y < -10 && ((moveEmitter.sys->particles.at(0).velocity.y > 1) || (moveEmitter.sys->particles.at(0).velocity.y < -1)))) {
-			emitter2.sys->reset();
-			emitter2.start();
-			moveEmitter.sys->particles.at(0).velocity = glm::vec3(0, 0, 0);
-			moveEmitter.sys->particles.at(0).angularVelocity = 0;
-		}
+	if (!bounds.overlap(landArea) && collide && !simInput.thrust) {
+		thrusterIsOn = false;
+		landerBody.stop();
+	}
+	else if (collide && bounds.overlap(landArea) && ((landerBody.velocity.y < 5) || (landerBody.velocity.y > -5))) {
+		landerBody.velocity = glm::vec3(0, 0, 0);
+		youWon = true;
+		landerBody.angularVelocity = 0;
+	}
+	else if (collide && bounds.overlap(landArea) && ((landerBody.velocity.y > 5) || (landerBody.velocity.y < -5))) {
+		died = true;
+		youWon = false;
+		thrusterIsOn = false;
+		emitter2.sys->reset();
+		emitter2.start();
+		landerBody.stop();
+
+		crashes++;
+	}
 
-		if (!bounds.overlap(landArea) && collide && !keymap[' ']) {
-			thrusterIsOn = false;
-			moveEmitter.sys->particles.at(0).velocity = glm::vec3(0, 0, 0);
-			moveEmitter.sys->particles.at(0).angularVelocity = 0;
-		}
-		else if (collide && bounds.overlap(landArea) && ((moveEmitter.sys->particles.at(0).velocity.y < 5) || (moveEmitter.sys->particles.at(0).velocity.y > -5))) {
-			moveEmitter.sys->particles.at(0).velocity = glm::vec3(0, 0, 0);
-			youWon = true;
-			moveEmitter.sys->particles.at(0).angularVelocity = 0;
-		}
-		else if (collide && bounds.overlap(landArea) && ((moveEmitter.sys->particles.at(0).velocity.y > 5) || (moveEmitter.sys->particles.at(0).velocity.y < -5))) {
-			died = true;
-			youWon = false;
-			thrusterIsOn = false;
-			emitter2.sys->reset();
-			emitter2.start();
-			moveEmitter.sys->particles.at(0).velocity = glm::vec3(0, 0, 0);
-			moveEmitter.sys->particles.at(0).angularVelocity = 0;
+	// Resting on the terrain:  move the lander back out along the deepest
+	// contact so it doesn't sink in a little further every step.
+	//
+	const Contact * deepest = NULL;
+	for (int i = 0; i < int(contacts.size()); i++) {
+		if (deepest == NULL || contacts[i].depth > deepest->depth) deepest = &contacts[i];
+	}
+	if (deepest != NULL) landerBody.position += deepest->normal * deepest->depth;
+}
 
-			if (!landerDead.isPlaying())
-				landerDead.play();
-			else if (landerDead.isPlaying())
-				landerDead.stop();
-		}
+//--------------------------------------------------------------
+// updateAudio:  sound effects for the latest step's thruster and game
+// state.  Nothing here touches a sound player, it only queues commands.
+//
+void ofApp::updateAudio() {
+	const SimSnapshot & sim = snapshots.front();
+	if (!simulationToggle) return;
+
+	// Only changes are sent; the audio thread does the rest.
+	//
+	if (sim.thrusterIsOn != thrusterSounding) {
+		thrusterSounding = sim.thrusterIsOn;
+		if (thrusterSounding) audio.hold(thrusterSound);
+		else audio.release(thrusterSound);
+	}
+
+	if (sim.youWon != winSounding) {
+		winSounding = sim.youWon;
+		if (winSounding) audio.hold(winSound);
+		else audio.release(winSound);
+	}
+
+	if (sim.crashes != crashesPlayed) {
+		crashesPlayed = sim.crashes;
+		audio.trigger(landerDead);
 	}
 }
 
 //--------------------------------------------------------------
 void ofApp::updateCameras() {
 	const auto landerPosition = lander.getPosition();
+	const SimSnapshot & sim = snapshots.front();
 
-	followCam.orbitDeg(moveEmitter.sys->particles.at(0).rotation+0.0f, -45.0f, 25.0f,
+	followCam.orbitDeg(sim.landerRotation+0.0f, -45.0f, 25.0f,
 		landerPosition);
-	onboardCam.orbitDeg(moveEmitter.sys->particles.at(0).rotation+0.0f, 270.0f, 0.7f,
+	onboardCam.orbitDeg(sim.landerRotation+0.0f, 270.0f, 0.7f,
 		landerPosition);
 	trackingCam.lookAt(landerPosition);
 }
@@ -490,6 +820,11 @@ void ofApp::updateCameras() {
 // 
 //--------------------------------------------------------------
 void ofApp::draw() {
+	PROFILE_SCOPE("draw");
+	if (!loader.done()) {
+		drawLoading();
+		return;
+	}
 	glDepthMask(false);
 	ofSetColor(ofColor::white);
 	// Draws background.
@@ -503,9 +838,21 @@ void ofApp::draw() {
 	ofPushMatrix();
 
 	ofEnableLighting();
-	planeMaterial.begin();
-	land.drawFaces();
-	planeMaterial.end();
+	{
+		PROFILE_SCOPE("draw.terrain");
+		planeMaterial.begin();
+		ofPushMatrix();
+		ofMultMatrix(land.getModelMatrix());
+		glm::vec4 eye = glm::inverse(glm::mat4(land.getModelMatrix())) * glm::vec4(currentCam->getPosition(), 1);
+		terrainChunks.setView(glm::vec3(eye.x, eye.y, eye.z), currentCam->getFov(), ofGetViewportHeight());
+		terrainChunks.cull(currentCam->getModelViewProjectionMatrix() * land.getModelMatrix());
+		terrainChunks.draw();
+		ofPopMatrix();
+		planeMaterial.end();
+		PROFILE_COUNT("terrain.chunksTested", terrainChunks.chunksTested);
+		PROFILE_COUNT("terrain.chunksDrawn", terrainChunks.chunksDrawn);
+		PROFILE_COUNT("terrain.trianglesDrawn", terrainChunks.trianglesDrawn);
+	}
 	ofNoFill();
 
 	// Draws landing area.
@@ -514,28 +861,42 @@ void ofApp::draw() {
 
 	ofFill();
 	ofMesh mesh;
+	const SimSnapshot & sim = snapshots.front();
 	if (bLanderLoaded) {
 		// If the lander hasn't exploded, then draw the lander and thruster emitter.
-		//
-		if (!died) {
-			lander.drawFaces();
-			emitter.draw();
-			moveEmitter.draw();
-		}
 		// Else, draw explode emitter.
-		else {
-			emitter2.draw();
+		//
+		// Either way the particles go back to front, blended, without
+		// writing depth, so they overlap each other in the right order.
+		//
+		if (!sim.died) lander.drawFaces();
+		const vector<Particle> & particles = sim.died ? sim.explosion : sim.exhaust;
+		{
+			PROFILE_SCOPE("draw.particleSort");
+			particleSort.sort(particles, currentCam->getModelViewMatrix());
 		}
+		PROFILE_COUNT("particles.drawn", particles.size());
+		ofEnableAlphaBlending();
+		glDepthMask(false);
+		for (int i = 0; i < int(particleSort.order.size()); i++) particles[particleSort.order[i]].draw();
+		glDepthMask(true);
 		if (!bTerrainSelected) drawAxis(lander.getPosition());
 		if (bDisplayBBoxes) {
 			ofNoFill();
 			ofSetColor(ofColor::white);
-			for (int i = 0; i < lander.getNumMeshes(); i++) {
-				ofPushMatrix();
-				ofMultMatrix(lander.getModelMatrix());
-				ofRotate(-90, 1, 0, 0);
-				Octree::drawBox(bboxList[i]);
-				ofPopMatrix();
+			// in the frame the collision uses, which is what they're for
+			//
+			ofPushMatrix();
+			ofMultMatrix(LanderBody::modelToWorld(sim.landerPosition, sim.landerRotation));
+			for (int i = 0; i < int(bboxList.size()); i++) Octree::drawBox(bboxList[i]);
+			ofPopMatrix();
+
+			// narrow phase contacts and their normals
+			//
+			ofSetColor(ofColor::red);
+			for (int i = 0; i < int(sim.contacts.size()); i++) {
+				const Contact & c = sim.contacts[i];
+				ofDrawLine(c.point, c.point + c.normal);
 			}
 		}
 
@@ -553,55 +914,65 @@ void ofApp::draw() {
 	ofPopMatrix();
 	currentCam->end();
 
-	// GUI Strings.
+	// GUI Strings.  Texts are only built when the value they show
+	// changes.
 	//
 	if (guiEnabled) {
-		ofSetColor(ofColor::white);
-		string velocityString;
-		velocityString += "Velocity: " + std::to_string(int(abs(moveEmitter.sys->particles.at(0).velocity.y))) + " m/s";
-		ofDrawBitmapString(velocityString, ofPoint(ofGetWindowWidth() / 2.2, 20));
-		string fuelString;
-		fuelString += "Fuel: " + std::to_string(int(fuel / 100)) + " second(s) remaining";
-		ofDrawBitmapString(fuelString, ofPoint(ofGetWindowWidth() / 2.2, 40));
-		string altitudeString;
-		if (altitudeTriggered)
-			altitudeString += "Altitude: " + std::to_string(int(moveEmitter.sys->particles.at(0).position.y)) + " meters";
-		ofDrawBitmapString(altitudeString, ofPoint(ofGetWindowWidth() / 2.2, 60));
-		string simulationString;
-		if (simulationToggle) {
-			simulationString = "Simulation: On";
-		}
-		else if (!simulationToggle) {
-			simulationString = "Simulation: Off";
-			ofDrawBitmapString("Simulation is Off. Press P to start simulation.", ofPoint(ofGetWindowWidth() / 2.4, ofGetWindowHeight() / 2));
-		}
-		ofDrawBitmapString(simulationString, ofPoint(ofGetWindowWidth() / 2.2, 80));
-		ofDrawBitmapString("Can mouse drag in freecam while simulation is off", ofPoint(ofGetWindowWidth() / 2.4, 100));
-		ofDrawBitmapString("and if the free cam is locked.", ofPoint(ofGetWindowWidth() / 2.2, 120));
-
-		ofDrawBitmapString("Tips:", ofPoint(ofGetWindowWidth() - 300, 20));
-		ofDrawBitmapString("WASD to move", ofPoint(ofGetWindowWidth() - 300, 40));
-		ofDrawBitmapString("Spacebar to move up", ofPoint(ofGetWindowWidth() - 300, 60));
-		ofDrawBitmapString("Rotate lander with Q or E", ofPoint(ofGetWindowWidth() - 300, 80));
-		ofDrawBitmapString("1 for follow cam", ofPoint(ofGetWindowWidth() - 300, 100));
-		ofDrawBitmapString("2 for onboard cam", ofPoint(ofGetWindowWidth() - 300, 120));
-		ofDrawBitmapString("3 for tracking cam", ofPoint(ofGetWindowWidth() - 300, 140));
-		ofDrawBitmapString("4 for free cam", ofPoint(ofGetWindowWidth() - 300, 160));
-		ofDrawBitmapString("C to lock cam during free cam", ofPoint(ofGetWindowWidth() - 300, 180));
-		ofDrawBitmapString("X to see altitude", ofPoint(ofGetWindowWidth() - 300, 200));
-		ofDrawBitmapString("Land on the landing zone to win", ofPoint(ofGetWindowWidth() - 300, 220));
-
-		string ifDied;
-		string ifWin;
-		if (youWon) {
-			ifWin += "You Won! Press P to play again.";
-			ofDrawBitmapString(ifWin, ofPoint(ofGetWindowWidth() / 2.4, ofGetWindowHeight() / 2));
-		}
-		if (died) {
-			ifDied += "You Died. Press P to play again.";
-			ofDrawBitmapString(ifDied, ofPoint(ofGetWindowWidth() / 2.4, ofGetWindowHeight() / 2));
+		PROFILE_SCOPE("draw.hud");
+		int velocity = int(abs(sim.landerVelocity.y));
+		if (hud.changed(hudVelocity, velocity)) {
+			hud.setText(hudVelocity, "Velocity: " + std::to_string(velocity) + " m/s");
 		}
+		int fuel = sim.fuel / 100;
+		if (hud.changed(hudFuel, fuel)) {
+			hud.setText(hudFuel, "Fuel: " + std::to_string(fuel) + " second(s) remaining");
+		}
+		int altitude = int(sim.altitude);
+		if (hud.changed(hudAltitude, altitudeTriggered ? altitude : INT_MIN)) {
+			hud.setText(hudAltitude, altitudeTriggered ? "Altitude: " + std::to_string(altitude) + " meters" : "");
+		}
+		if (hud.changed(hudSimulation, simulationToggle)) {
+			hud.setText(hudSimulation, simulationToggle ? "Simulation: On" : "Simulation: Off");
+			hud.setText(hudSimulationOff, simulationToggle ? "" : "Simulation is Off. Press P to start simulation.");
+		}
+		if (hud.changed(hudWon, sim.youWon)) {
+			hud.setText(hudWon, sim.youWon ? "You Won! Press P to play again." : "");
+		}
+		if (hud.changed(hudDied, sim.died)) {
+			hud.setText(hudDied, sim.died ? "You Died. Press P to play again." : "");
+		}
+		hud.draw();
+		PROFILE_COUNT("hud.texts", hud.stats.textsBuilt);
+		PROFILE_COUNT("hud.rasterized", hud.stats.linesRasterized);
+		PROFILE_COUNT("hud.drawCalls", hud.stats.drawCalls);
 	}
+
+	// Profiler overlay, left side under the gui.
+	//
+	Profiler::instance().draw(20, ofGetWindowHeight() / 2);
+	renderWorkMs = (ofGetElapsedTimeMicros() - frameStartMicros) / 1000.0;
+}
+
+//--------------------------------------------------------------
+//
+//  Draw Loading
+// 
+//  Description: 
+//  Loading screen - progress bar and the assets in progress.
+// 
+//--------------------------------------------------------------
+void ofApp::drawLoading() {
+	ofBackground(ofColor::black);
+	float w = ofGetWindowWidth() / 3;
+	float x = (ofGetWindowWidth() - w) / 2;
+	float y = ofGetWindowHeight() / 2;
+
+	ofSetColor(ofColor::white);
+	ofDrawBitmapString("Loading " + loader.status(), ofPoint(x, y - 10));
+	ofNoFill();
+	ofDrawRectangle(x, y, w, 12);
+	ofFill();
+	ofDrawRectangle(x, y, w * loader.progress(), 12);
 }
 
 //--------------------------------------------------------------
@@ -647,9 +1018,11 @@ void ofApp::drawAxis(ofVec3f location) {
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key) {
 	keymap[key] = true;
+	updateInput();
 	switch (key) {
 	case 'B':
 	case 'b':
+		bDisplayBBoxes = !bDisplayBBoxes;
 		break;
 	case 'C':
 	case 'c':
@@ -669,15 +1042,33 @@ void ofApp::keyPressed(int key) {
 	case 'I':
 	case 'i':
 		break;
+	case 'G':
+	case 'g':
+		hud.bCache = !hud.bCache;
+		break;
 	case 'H':
 	case 'h':
 		guiEnabled = !guiEnabled;
 		break;
 	case 'L':
 	case 'l':
+		Profiler::instance().dumpCSV(ofToDataPath("profile.csv"));
+		Profiler::instance().dumpTrace(ofToDataPath("profile_trace.json"));
+		ofLogNotice("Profiler") << "profile written to " << ofToDataPath("profile.csv") << " and profile_trace.json";
+		{
+			const QueryStats & stats = snapshots.front().queryStats;
+			ofLogNotice("Profiler") << "terrain queries: " << stats.queries << " nodes visited: " << stats.nodesVisited
+				<< " box tests: " << stats.boxTests << " leaves: " << stats.leavesReached
+				<< " results: " << stats.results << " max depth: " << stats.maxDepth;
+			ofLogNotice("Profiler") << "sim steps: " << simThread.steps << " dropped: " << simThread.dropped;
+		}
 		break;
 	case 'O':
 	case 'o':
+		// the zones only time (and trace) while the overlay is up
+		//
+		Profiler::instance().bShowOverlay = !Profiler::instance().bShowOverlay;
+		Profiler::instance().enabled = Profiler::instance().bShowOverlay;
 		break;
 	case 'r':
 		break;
@@ -732,11 +1123,11 @@ void ofApp::keyPressed(int key) {
 //--------------------------------------------------------------
 void ofApp::keyReleased(int key) {
 	keymap[key] = false;
-	thrusterIsOn = false;
-	upForce = 0.0;
-	frontForce = 0.0;
-	sideForce = 0.0;
-	angularForce = 0.0;
+	updateInput();
+
+	// Cuts the thrusters; the sim thread does it on its next step.
+	//
+	input.releases++;
 	switch (key) {
 	
 	case OF_KEY_ALT:
@@ -745,18 +1136,32 @@ void ofApp::keyReleased(int key) {
 		break;
 	case OF_KEY_SHIFT:
 		break;
-	case 'E':
-	case 'e':
-	case 'Q':
-	case 'q':
-		angularForce = 0.0;
-		break;
 	default:
 		break;
 
 	}
 }
 
+//--------------------------------------------------------------
+// updateInput:  the movement keys held, for the sim thread
+//
+void ofApp::updateInput() {
+	input.forward = keymap['W'] || keymap['w'] || keymap[OF_KEY_UP];
+	input.left = keymap['A'] || keymap['a'] || keymap[OF_KEY_LEFT];
+	input.back = keymap['S'] || keymap['s'] || keymap[OF_KEY_DOWN];
+	input.right = keymap['D'] || keymap['d'] || keymap[OF_KEY_RIGHT];
+	input.thrust = keymap[' '];
+	input.restart = keymap['P'] || keymap['p'];
+	input.rotateLeft = keymap['Q'] || keymap['q'];
+	input.rotateRight = keymap['E'] || keymap['e'];
+}
+
+//--------------------------------------------------------------
+void ofApp::exit() {
+	simThread.stop();
+	audio.stop();
+}
+
 //--------------------------------------------------------------
 void ofApp::mouseMoved(int x, int y) {
 
@@ -774,9 +1179,9 @@ void ofApp::mouseMoved(int x, int y) {
 //--------------------------------------------------------------
 void ofApp::mousePressed(int x, int y, int button) {
 
-	// if moving camera, don't allow mouse interaction
+	// if moving camera or still loading, don't allow mouse interaction
 	//
-	if (freeCam.getMouseInputEnabled()) return;
+	if (freeCam.getMouseInputEnabled() || !loader.done()) return;
 
 	// if rover is loaded, test for selection
 	//
@@ -826,14 +1231,6 @@ void ofApp::mouseDragged(int x, int y, int button) {
 		landerPos += delta;
 		lander.setPosition(landerPos.x, landerPos.y, landerPos.z);
 		mouseLastPos = mousePos;
-
-		ofVec3f min = lander.getSceneMin() + lander.getPosition();
-		ofVec3f max = lander.getSceneMax() + lander.getPosition();
-
-		Box bounds = Box(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z));
-
-		colBoxList.clear();
-		octree.intersect(bounds, octree.root, colBoxList);
 	}
 }
 
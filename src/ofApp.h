@@ -14,8 +14,23 @@
 #include "ofxGui.h"
 #include  "ofxAssimpModelLoader.h"
 #include "Octree.h"
+#include "TerrainChunks.h"
+#include "Heightfield.h"
+#include "Hud.h"
+#include "FrameArena.h"
+#include "AudioSystem.h"
+#include "AssetLoader.h"
+#include "JobSystem.h"
+#include "SimThread.h"
+#include "TripleBuffer.h"
+#include "TextureCache.h"
 #include "Particle.h"
 #include "ParticleEmitter.h"
+#include "ParticleBudget.h"
+#include "DepthSort.h"
+#include "Lander.h"
+#include "ConvexHull.h"
+#include "Narrowphase.h"
 #include <glm/gtx/intersect.hpp>
 #include "vector3.h"
 
@@ -33,6 +48,7 @@ class ofApp : public ofBaseApp {
 		void setup();
 		void update();
 		void draw();
+		void exit();
 
 		void keyPressed(int key);
 		void keyReleased(int key);
@@ -54,6 +70,20 @@ class ofApp : public ofBaseApp {
 
 		void soundSetup();
 
+		void simulate(float dt);
+		void publishSnapshot();
+		void updateInput();
+		void prepareFrame();
+		void updateControls();
+		void queryTerrain();
+		void narrowPhase();
+		void collisionResponse();
+		bool belowGround() const;
+		void updateAudio();
+
+		void buildTerrain();
+		void drawLoading();
+
 		bool mouseIntersectPlane(ofVec3f planePoint, ofVec3f planeNorm, ofVec3f &point);
 		bool raySelectWithOctree(ofVec3f &pointRet);
 		glm::vec3 ofApp::getMousePointOnPlane(glm::vec3 p , glm::vec3 n);
@@ -67,11 +97,21 @@ class ofApp : public ofBaseApp {
 		ofxAssimpModelLoader land, lander;
 		ofLight light;
 		Box boundingBox, landerBounds, marsBounds;
+		OBB landerOBB;                  // lander box turned with the body, for collisions
 		Box landArea;
 		vector<Box> colBoxList;
 		bool bLanderSelected = false;
 		Octree octree;
-		TreeNode selectedNode;
+		SpatialIndex *terrainIndex = &octree;
+		QueryStats terrainQueryStats;     // all terrain queries since startup
+		TerrainChunks terrainChunks;
+		Heightfield heightfield;          // altitude and the broad phase reject
+		Hud hud;
+		uint64_t frameAllocs = 0;         // heapAllocations() at the last frame
+		int hudVelocity, hudFuel, hudAltitude, hudSimulation, hudSimulationOff, hudWon, hudDied;
+		AssetLoader loader;
+		JobSystem jobs;
+		ofMesh terrainMesh;               // handed to the octree build, cleared after
 		glm::vec3 mouseDownPos, mouseLastPos;
 		bool bInDrag = false;
 
@@ -107,7 +147,17 @@ class ofApp : public ofBaseApp {
 		ofVec3f selectedPoint;
 		ofVec3f intersectPoint;
 
-		vector<Box> bboxList;
+		vector<Box> bboxList;             // per lander sub-mesh, model space
+
+		// Narrow phase:  a convex hull per lander sub-mesh (model space,
+		// built when the lander loads), tested against the terrain
+		// triangles under the lander's OBB.  The rest is sim thread
+		// scratch and this step's contacts.
+		//
+		vector<ConvexHull> landerHulls;
+		vector<glm::vec3> hullWorld;
+		vector<int> terrainTriangles;
+		vector<Contact> contacts;
 
 		const float selectionRange = 4.0;
 
@@ -115,11 +165,6 @@ class ofApp : public ofBaseApp {
 		glm::vec3 landerPos;
 		int landerRot;
 
-		glm::vec3 heading() {
-			glm::vec3 rotate(cos(moveEmitter.sys->particles.at(0).rotation), 0, sin(moveEmitter.sys->particles.at(0).rotation));
-			return (glm::normalize(rotate));
-		}
-
 		ofxVec3Slider minTurbulence;
 		ofxVec3Slider maxTurbulence;
 
@@ -131,12 +176,13 @@ class ofApp : public ofBaseApp {
 		ofxFloatSlider radialForceVal;
 		ofxFloatSlider radialHeightVal;
 
-		ParticleEmitter emitter;
-		ParticleEmitter emitter2;
-		ParticleEmitter moveEmitter;
+		ShapeEmitter<ConeShape> emitter;         // thruster exhaust
+		ShapeEmitter<RadialShape> emitter2;      // explosion
+		ParticleBudget particleBudget;            // caps both emitters together
+		DepthSort particleSort;                   // back to front draw order
+		LanderBody landerBody;
 		TurbulenceForce *turbForce;
 		GravityForce *gravityForce;
-		DirectionalForce *dirForce;
 		ImpulseRadialForce *radialForce;
 		float upForce = 0.0;
 		float frontForce = 0.0;
@@ -161,10 +207,31 @@ class ofApp : public ofBaseApp {
 		ofxFloatSlider planeMaterialSpecularBlue;
 
 		ofMaterial planeMaterial;
-		ofImage background;
-
-		ofSoundPlayer thrusterSound;
-		ofSoundPlayer landerDead;
-		ofSoundPlayer winSound;
-		ofSoundPlayer backgroundSound;
+		ofTexture background;
+		TextureCache textureCache;
+		CachedTexture backgroundCache;    // mapped on a loader thread
+
+		AudioSystem audio;
+		int thrusterSound, landerDead, winSound, backgroundSound;
+		bool thrusterSounding = false;    // last state sent to audio
+		bool winSounding = false;
+
+		// Simulation thread.  Everything the step touches (emitters,
+		// forces, fuel, game state, colBoxList) belongs to the sim
+		// thread once it starts; the render thread sees it only
+		// through the snapshots.
+		//
+		const float simRate = 60;         // steps per second
+		TripleBuffer<SimInput> inputs;
+		TripleBuffer<SimSnapshot> snapshots;
+		SimInput input;                   // render thread, sent every frame
+		SimInput simInput;                // sim thread copy for this step
+		int releasesSeen = 0;
+		uint64_t frameStartMicros = 0;    // render thread, start of update()
+		float renderWorkMs = 0;           // render thread, update() + draw() of the last frame
+		float simStepMs = 0;              // sim thread, the last step
+		int crashes = 0;                  // sim thread
+		int crashesPlayed = 0;            // render thread
+		glm::vec3 landerSceneMin, landerSceneMax;
+		SimThread simThread;              // last, so it stops before the rest goes away
 };
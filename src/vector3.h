@@ -9,6 +9,8 @@ class Vector3 {
     Vector3(float x, float y, float z) { d[0] = x; d[1] = y; d[2] = z; }
     Vector3(const Vector3 &v)
       { d[0] = v.d[0]; d[1] = v.d[1]; d[2] = v.d[2]; }
+    Vector3 &operator=(const Vector3 &v)
+      { d[0] = v.d[0]; d[1] = v.d[1]; d[2] = v.d[2]; return *this; }
 
     float x() const { return d[0]; }
     float y() const { return d[1]; }